@@ -0,0 +1,145 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "History.hpp"
+
+using namespace stars;
+
+namespace {
+
+/// Line count and skippable (empty or '#') count of one load.
+struct Result {
+    std::size_t lines = 0;
+    std::size_t skippable = 0;
+    double seconds = 0;
+};
+
+/// Bash-like history of about bytes: commands with flags and arguments, epoch lines, comments and
+/// blank lines, from a fixed seed so every run reads the same input.
+void writeHistory(const std::filesystem::path& path, std::uint64_t bytes) {
+    static const char* kBases[] = {"ls", "git", "cd", "make", "grep", "docker", "kubectl", "vim", "ssh", "cargo"};
+    static const char* kFlags[] = {"-l", "-a", "-r", "--all", "-v", "--force", "-n", "--pretty=oneline"};
+    std::mt19937_64 rng(2);
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) throw std::runtime_error("Cannot write " + path.string());
+
+    std::string chunk;
+    std::uint64_t written = 0;
+    std::uint64_t epoch = 1700000000;
+    while (written < bytes) {
+        chunk.clear();
+        while (chunk.size() < (1 << 20)) {
+            const auto pick = rng() % 100;
+            if (pick < 30) {
+                epoch += rng() % 600;
+                chunk += '#' + std::to_string(epoch) + '\n';
+                continue;
+            }
+            if (pick < 32) {
+                chunk += "# note to self\n";
+                continue;
+            }
+            if (pick < 34) {
+                chunk += '\n';
+                continue;
+            }
+            chunk += kBases[rng() % std::size(kBases)];
+            for (auto flags = rng() % 4; flags > 0; --flags) (chunk += ' ') += kFlags[rng() % std::size(kFlags)];
+            for (auto args = rng() % 3; args > 0; --args) chunk += " path/to/file" + std::to_string(rng() % 1000);
+            chunk += '\n';
+        }
+        out.write(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+        written += chunk.size();
+    }
+}
+
+/// The ingestion path before the scanner: std::getline into strings, then a per-line skip check.
+Result loadWithGetline(const std::filesystem::path& path) {
+    const auto start = std::chrono::steady_clock::now();
+    std::ifstream in(path);
+    if (!in.is_open()) throw std::runtime_error("Cannot open " + path.string());
+    std::vector<std::string> lines;
+    std::string line;
+    while (std::getline(in, line)) lines.push_back(line);
+
+    Result result;
+    // Command::isSkippableLine's check, which the parser ran per line before the bitmap.
+    for (const auto& text : lines) result.skippable += text.empty() || text[0] == '#' ? 1 : 0;
+    result.lines = lines.size();
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+/// History's mapped, vectorized line index with its skippable bitmap.
+Result loadWithScanner(const std::filesystem::path& path) {
+    const auto start = std::chrono::steady_clock::now();
+    History history;
+    history.loadFromFile(path.string());
+
+    Result result;
+    for (bool skippable : history.getSkippable()) result.skippable += skippable ? 1 : 0;
+    result.lines = history.getLines().size();
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+void report(const char* name, const Result& result, const Result& baseline) {
+    std::cout << name << ": " << result.seconds << " s, " << result.lines << " lines, " << result.skippable
+              << " skippable";
+    if (result.seconds > 0) std::cout << ", " << baseline.seconds / result.seconds << "x";
+    std::cout << "\n";
+    if (result.lines != baseline.lines || result.skippable != baseline.skippable) {
+        throw std::runtime_error(std::string(name) + " disagrees with getline");
+    }
+}
+
+}  // namespace
+
+/// Time loading a synthetic history through std::getline and through History's scan kernels.
+/// Usage: stars_scan_benchmark [bytes = 1 GiB] [history file, generated unless it exists]
+int main(int argc, char** argv) {
+    try {
+        const std::uint64_t bytes = argc > 1 ? std::stoull(argv[1]) : std::uint64_t{1} << 30;
+        const bool generated = argc <= 2;
+        const std::filesystem::path path =
+            generated ? std::filesystem::temp_directory_path() / "stars-scan-benchmark.history" : argv[2];
+        if (generated || !std::filesystem::exists(path)) {
+            std::cout << "writing " << bytes << " bytes to " << path.string() << "\n";
+            writeHistory(path, bytes);
+        }
+
+        // The first read also warms the page cache for the rest.
+        loadWithScanner(path);
+        const Result baseline = loadWithGetline(path);
+        std::cout << "getline: " << baseline.seconds << " s, " << baseline.lines << " lines, "
+                  << baseline.skippable << " skippable\n";
+
+        const std::pair<const char*, History::ScanKernel> kernels[] = {{"scalar", History::ScanKernel::Scalar},
+                                                                       {"sse2", History::ScanKernel::Sse2},
+                                                                       {"avx2", History::ScanKernel::Avx2},
+                                                                       {"auto", History::ScanKernel::Auto}};
+        for (const auto& [name, kernel] : kernels) {
+            if (!History::setScanKernel(kernel)) {
+                std::cout << name << ": not supported by this CPU\n";
+                continue;
+            }
+            report(name, loadWithScanner(path), baseline);
+        }
+
+        if (generated) std::filesystem::remove(path);
+    } catch (const std::exception& e) {
+        std::cerr << "stars_scan_benchmark: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Renderer.hpp"
+
+namespace stars {
+
+/// Screensaver frames. Each frame composes the rendered scene with time-based effects (twinkling
+/// stars, fading connectors, a slow horizontal pan) into a back buffer, and emits only the cells
+/// that differ from the front buffer (what the terminal shows) as cursor moves and coalesced runs,
+/// changing colour only where it differs from the last glyph written. Bytes per frame follow what
+/// changed, not the terminal size.
+class Animator {
+   public:
+    Animator() = default;
+
+    /// Compose the scene at elapsed time and return the escapes that bring the screen up to date;
+    /// empty when nothing changed. Valid until the next frame(). The first frame, and the first
+    /// after a size change or reset(), clears the screen.
+    std::string_view frame(const Renderer& scene, std::chrono::milliseconds elapsed);
+
+    /// Forget what the screen shows, e.g. after other output, so the next frame repaints it all.
+    void reset();
+
+    /// Cells the screen shows after the last frame, row-major; spaces have heat 0.
+    const std::vector<Renderer::Cell>& getScreen() const;
+
+   private:
+    /// Time to pan the sky by one column.
+    static constexpr std::int64_t kPanMillis = 500;
+    /// Each star twinkles once per period, for kTwinkleMillis, at its own phase.
+    static constexpr std::int64_t kTwinklePeriodMillis = 5000;
+    static constexpr std::int64_t kTwinkleMillis = 600;
+    /// Connectors fade out to kMinFade/256 of their cells and back in over this period.
+    static constexpr std::int64_t kFadePeriodMillis = 12000;
+    static constexpr std::uint32_t kMinFade = 96;
+    /// Unchanged cells between two changed ones are rewritten rather than skipped with a cursor move
+    /// up to this gap, unless that needs a colour change; "\x1b[<n>C" is never shorter.
+    static constexpr std::size_t kMaxRewrite = 4;
+
+    std::size_t width_ = 0;
+    std::size_t height_ = 0;
+    std::vector<Renderer::Cell> front_;  ///< What the terminal shows.
+    std::vector<Renderer::Cell> back_;   ///< Frame being composed.
+    std::string output_;                 ///< Escapes of the last frame, rewritten in place.
+
+    void compose(const Renderer& scene, std::int64_t millis);
+    void emitChanges(const Renderer& scene);
+    void moveTo(std::size_t x, std::size_t y);
+    void appendNumber(std::size_t value);
+};
+
+}  // namespace stars
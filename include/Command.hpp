@@ -1,30 +1,105 @@
 #pragma once
 
-#include <string>
+#include <boost/container/small_vector.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
 #include <vector>
 
 namespace stars {
 
+/// A normalized history entry. Every view points into the parsed line or into the batch Arena,
+/// so both must outlive the Command.
 class Command {
    public:
-    std::string original;
-    std::string base;
-    std::vector<std::string> flags;
-    std::vector<std::string> args;
+    /// Chunked storage for tokens that had to be rewritten (unquoted / unescaped).
+    class Arena {
+       public:
+        Arena() = default;
+
+        /// Make n contiguous writable bytes available at the cursor without consuming them.
+        char* reserve(std::size_t n);
+        /// Consume n bytes of the last reservation and return them as a stable view.
+        std::string_view commit(std::size_t n);
+        /// Take ownership of another arena's blocks; views into them stay valid.
+        void adopt(Arena&& other);
+
+       private:
+        static constexpr std::size_t kBlockSize = 64 * 1024;
+
+        std::vector<std::unique_ptr<char[]>> blocks_;
+        char* cursor_ = nullptr;
+        std::size_t available_ = 0;
+    };
+
+    using Tokens = boost::container::small_vector<std::string_view, 4>;
+
+    /// On-disk history layouts, one adapter each.
+    enum class Format {
+        Bash,  ///< One command per line, optionally preceded by "#<epoch>" lines (HISTTIMEFORMAT).
+        Zsh,   ///< EXTENDED_HISTORY ": <epoch>:<elapsed>;<command>", continued after a trailing '\'.
+    };
+
+    std::string_view original;
+    std::string_view base;
+    Tokens flags;  ///< Sorted.
+    Tokens args;
     std::size_t index;
+    std::int64_t timestamp;  ///< Epoch seconds from the last preceding "#<epoch>" line; 0 if none.
 
     Command();
 
-    /// Parse a list of raw history lines into normalized Command objects.
-    static std::vector<Command> parseLines(const std::vector<std::string>& lines);
+    /// Parse raw history line views (e.g. History::getLines()) into normalized Command objects.
+    /// skippable may carry the scanner's per-line classification (History::getSkippable());
+    /// firstIndex is the history index of lines[0] (History::getFirstLineNumber()).
+    /// threads > 1 parses contiguous chunks concurrently (0 = one per hardware thread); the result
+    /// is identical to the serial parse. timestamp is the time in effect before lines[0].
+    static std::vector<Command> parseLines(const std::vector<std::string_view>& lines,
+                                           Arena& arena,
+                                           const std::vector<bool>& skippable = {},
+                                           std::size_t firstIndex = 0,
+                                           std::size_t threads = 1,
+                                           std::int64_t timestamp = 0);
+
+    /// Bash HISTTIMEFORMAT line: '#' followed only by digits. Sets time on success.
+    static bool parseTimestamp(std::string_view line, std::int64_t& time);
+
+    /// Time in effect after lines (the last epoch line), or fallback when there is none.
+    static std::int64_t findLastTimestamp(const std::vector<std::string_view>& lines, std::int64_t fallback);
+
+    /// Zsh when the first non-empty line is an extended-history entry, Bash otherwise.
+    static Format detectFormat(const std::vector<std::string_view>& lines);
+
+    /// Zsh adapter: commands keep their entry's start time; lines without the entry prefix (written
+    /// before EXTENDED_HISTORY was set) are untimed. Continuation lines of multi-line entries are
+    /// skipped; continued carries a trailing '\' from the previous batch and is updated for the next.
+    static std::vector<Command> parseZshLines(const std::vector<std::string_view>& lines,
+                                              Arena& arena,
+                                              std::size_t firstIndex,
+                                              bool& continued);
+
+    /// Split ": <epoch>:<elapsed>;<command>" into time and command.
+    static bool parseZshEntry(std::string_view line, std::int64_t& time, std::string_view& command);
 
    private:
-    static bool isSkippableLine(const std::string& line);
-    static std::vector<std::string> tokenizeBoost(const std::string& line);
+    /// Below this many lines per worker, threads cost more than they save.
+    static constexpr std::size_t kMinLinesPerThread = 16 * 1024;
+    static constexpr std::size_t kNotCounted = static_cast<std::size_t>(-1);
 
-    static std::string extractBase(const std::vector<std::string>& normalized);
-    static std::vector<std::string> extractFlagsSorted(const std::vector<std::string>& normalized);
-    static std::vector<std::string> extractArgs(const std::vector<std::string>& normalized);
+    /// Parse lines [begin, end). timestamp is the time in effect at begin and is left at the time in
+    /// effect at end. Returns how many commands were stamped before the range's first epoch line.
+    static std::size_t parseRange(const std::vector<std::string_view>& lines,
+                                  const std::vector<bool>& skippable,
+                                  std::size_t begin,
+                                  std::size_t end,
+                                  std::size_t firstIndex,
+                                  std::int64_t& timestamp,
+                                  Arena& arena,
+                                  std::vector<Command>& out);
+    static bool isSkippableLine(std::string_view line);
+    static void tokenize(std::string_view line, Arena& arena, Command& cmd);
+    static std::size_t unquoteToken(std::string_view line, std::size_t pos, Arena& arena, std::string_view& token);
 };
 
 }  // namespace stars
@@ -1,7 +1,10 @@
 #pragma once
 
+#include <chrono>
 #include <cstddef>
+#include <cstdint>
 #include <string>
+#include <vector>
 
 namespace stars {
 
@@ -17,11 +20,75 @@ class Configuration {
     std::size_t getHeight() const;
     std::size_t getMaxConstellations() const;
 
+    /// Every history to draw; more than one are merged by timestamp. The first is getInputPath().
+    void setInputPaths(std::vector<std::string> paths);
+    const std::vector<std::string>& getInputPaths() const;
+
+    /// Keep running and redraw as the history file grows.
+    void setFollow(bool follow);
+    bool getFollow() const;
+
+    /// Reuse and refresh the graph snapshot cache between runs.
+    void setUseCache(bool useCache);
+    bool getUseCache() const;
+
+    /// Worker threads for parsing, graph building, layout and drawing; 0 means one per hardware thread.
+    void setThreads(std::size_t threads);
+    std::size_t getThreads() const;
+
+    /// Bytes for the heavy-hitter summaries of the top-k mode; 0 builds the exact full graph.
+    void setMemoryBudget(std::size_t bytes);
+    std::size_t getMemoryBudget() const;
+
+    /// Only count commands from the last seconds (0 = all history).
+    void setWindow(std::int64_t seconds);
+    std::int64_t getWindow() const;
+
+    /// Lay stars out force-directed instead of packed.
+    void setForceLayout(bool force);
+    bool getForceLayout() const;
+
+    /// Force layout budget: at most iterations steps, stopping early after time.
+    void setLayoutBudget(std::size_t iterations, std::chrono::milliseconds time);
+    std::size_t getLayoutIterations() const;
+    std::chrono::milliseconds getLayoutTime() const;
+
+    /// Screensaver mode: redraw continuously with twinkling, fading and panning.
+    void setAnimate(bool animate);
+    bool getAnimate() const;
+
+    /// Fastest frame rate accepted; terminals cannot show more, and the frame period stays well
+    /// above the clock's resolution.
+    static constexpr std::size_t kMaxFramesPerSecond = 1000;
+
+    /// Target animation frame rate, 1 to kMaxFramesPerSecond. Throws std::invalid_argument otherwise.
+    void setFramesPerSecond(std::size_t fps);
+    std::size_t getFramesPerSecond() const;
+
+    /// Heatmap colour depth in bits: 0 for none, 8 for 256 colours, 24 for truecolor.
+    void setColorDepth(int bits);
+    int getColorDepth() const;
+
+    /// "90", "30m", "12h", "7d" or "2w" in seconds. Throws std::invalid_argument otherwise.
+    static std::int64_t parseDuration(const std::string& text);
+
    private:
     std::string inputPath_;
+    std::vector<std::string> inputPaths_;
     std::size_t width_;
     std::size_t height_;
     std::size_t maxConstellations_;
+    bool follow_ = false;
+    bool useCache_ = true;
+    std::size_t threads_ = 0;
+    std::size_t memoryBudget_ = 0;
+    std::int64_t window_ = 0;
+    bool forceLayout_ = false;
+    std::size_t layoutIterations_ = 300;
+    std::chrono::milliseconds layoutTime_{30};
+    bool animate_ = false;
+    std::size_t framesPerSecond_ = 15;
+    int colorDepth_ = 0;
 };
 
 }  // namespace stars
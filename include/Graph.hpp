@@ -1,13 +1,24 @@
 #pragma once
 
+#include <boost/container/small_vector.hpp>
+#include <array>
+#include <barrier>
 #include <boost/graph/adjacency_list.hpp>
+#include <cstdint>
+#include <deque>
+#include <exception>
 #include <limits>
-#include <set>
+#include <memory>
+#include <optional>
+#include <span>
 #include <string>
+#include <string_view>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
 #include "Command.hpp"
+#include "History.hpp"
 
 namespace stars {
 
@@ -15,35 +26,165 @@ namespace stars {
 /// - Base commands become central stars.
 /// - Unique flag sets become variant stars attached to the base.
 /// - Specialization chains connect earlier variants to later strict supersets.
+/// Bases and flags are interned into dense integer symbols; labels are built on demand.
 class Graph {
    public:
+    using SymbolId = std::uint32_t;
+
+    /// Flag set as bits of the owning base's flag dictionary; one inline word covers 64 flags.
+    /// Kept normalized (no trailing zero words) so equal sets compare and hash equal.
+    struct FlagSet {
+        boost::container::small_vector<std::uint64_t, 1> words;
+
+        void set(std::size_t bit);
+        bool test(std::size_t bit) const;
+        std::size_t count() const;
+        /// (this & ~other) == 0, word by word.
+        bool isSubsetOf(const FlagSet& other) const;
+
+        bool operator==(const FlagSet& other) const = default;
+    };
+
+    static constexpr std::uint32_t kNoActivity = std::numeric_limits<std::uint32_t>::max();
+
+    /// Timestamped uses of one variant in ring-buffered buckets: hourly over the last day and daily
+    /// over the last kDays days, relative to its newest use, plus a decayed count ("heat").
+    struct Activity {
+        static constexpr std::size_t kHours = 24;
+        static constexpr std::size_t kDays = 64;
+        static constexpr double kHalfLifeSeconds = 7 * 24 * 3600.0;
+
+        std::int64_t newestHour = 0;  ///< Absolute hour (time / 3600) of the newest hourly bucket.
+        std::int64_t newestDay = 0;   ///< Absolute day (time / 86400) of the newest daily bucket.
+        std::int64_t lastSeen = 0;    ///< Newest timestamp recorded; 0 while empty.
+        double heat = 0;              ///< Decayed use count as of lastSeen.
+        std::array<std::uint32_t, kHours> hours{};
+        std::array<std::uint32_t, kDays> days{};
+
+        void add(std::int64_t time);
+        /// Uses at or after since, to bucket granularity; windows older than kDays are clamped.
+        std::uint64_t countSince(std::int64_t since) const;
+        /// Each use weighs 2^(-age / kHalfLifeSeconds) at now.
+        double heatAt(std::int64_t now) const;
+    };
+
     struct StarVertex {
-        std::string label;               ///< Display label, e.g., "<ls -al>".
-        std::string base;                ///< Base command (e.g., "ls").
-        std::set<std::string> flags;     ///< Sorted unique flags defining a variant.
+        SymbolId base = 0;               ///< Interned base command (e.g., "ls").
+        FlagSet flags;                   ///< Unique flags defining a variant, in base-local bits.
+        std::size_t flagCount = 0;       ///< Popcount of flags.
         std::size_t frequency = 0;       ///< Occurrence count (identical base+flags).
         bool isBase = false;             ///< True for central star.
         std::size_t firstSeenIndex = 0;  ///< Earliest history index for this node.
+        std::uint32_t activity = kNoActivity;  ///< Slot of its time buckets, once used with a timestamp.
     };
 
     using BoostGraph = boost::adjacency_list<boost::vecS, boost::vecS, boost::directedS, StarVertex>;
     using Vertex = BoostGraph::vertex_descriptor;
 
+    /// Read-only compressed form of a built graph for Layout and Renderer: vertex properties as
+    /// parallel arrays, out-edges and per-base variants in CSR form, labels in one string.
+    /// Vertex numbers are the Graph's, so positions keyed by Vertex apply to both.
+    class Frozen {
+       public:
+        Frozen() = default;
+
+        std::size_t getVertexCount() const;
+        std::size_t getEdgeCount() const;
+
+        bool isBase(Vertex v) const;
+        std::size_t getFlagCount(Vertex v) const;
+        /// Uses of a variant; for a base, the total over its variants. Saturates at UINT32_MAX.
+        std::size_t getFrequency(Vertex v) const;
+        std::size_t getFirstSeenIndex(Vertex v) const;
+        std::string_view getLabel(Vertex v) const;
+
+        /// Edge targets of v in the Graph's out-edge order.
+        std::span<const std::uint32_t> getOutEdges(Vertex v) const;
+        /// Base vertices ascending.
+        std::span<const std::uint32_t> getBaseVertices() const;
+        /// Variants of a base ordered by flag count, then first use; empty for variants.
+        std::span<const std::uint32_t> getVariantsForBase(Vertex baseVertex) const;
+
+       private:
+        friend class Graph;
+
+        std::vector<std::uint32_t> flagCounts_;
+        std::vector<std::uint32_t> frequencies_;
+        std::vector<std::uint64_t> firstSeen_;
+        std::vector<std::uint8_t> isBase_;
+
+        std::vector<std::uint32_t> edgeOffsets_;  // vertex -> first slot in edgeTargets_
+        std::vector<std::uint32_t> edgeTargets_;
+        std::vector<std::uint32_t> variantOffsets_;  // vertex -> first slot in variants_
+        std::vector<std::uint32_t> variants_;
+        std::vector<std::uint32_t> bases_;
+
+        std::vector<std::uint32_t> labelOffsets_;  // vertex -> first byte in labels_
+        std::string labels_;
+    };
+
     Graph() = default;
 
-    /// Build the constellation graph from normalized commands.
-    void build(const std::vector<Command>& commands);
+    /// Build the constellation graph from normalized commands. threads > 1 (0 = one per hardware
+    /// thread) partitions commands by base across workers; the result, including vertex and symbol
+    /// numbering, is identical to the serial build.
+    void build(const std::vector<Command>& commands, std::size_t threads = 1);
+
+    /// Fold newer commands into the graph without a rebuild: updates frequencies and firstSeenIndex,
+    /// adds new base/variant stars and relinks only the chains of touched bases.
+    /// Returns the vertices that were added or changed (properties or outgoing chain edge), ascending.
+    std::vector<Vertex> append(const std::vector<Command>& commands);
+
+    /// Folds batches arriving over time (e.g. from a Pipeline) as one append() of all of them would.
+    class Builder;
 
     const BoostGraph& getBoostGraph() const;
     std::vector<Vertex> getBaseVertices() const;
-    std::vector<Vertex> getVariantsForBase(Vertex baseVertex) const;
+    /// Variants of a base ordered by flag count, then first use. O(1), no allocation.
+    const std::vector<Vertex>& getVariantsForBase(Vertex baseVertex) const;
+
+    /// Persist symbols, stars, usage and edges with the fingerprint of the history they came from.
+    /// Written to a temporary file and renamed into place. Throws on I/O error.
+    void saveSnapshot(const std::string& path, const History::Fingerprint& source) const;
+
+    /// Replace this graph with a snapshot and return its source fingerprint; nullopt when the file
+    /// is missing, from another format version, or malformed. Symbol text stays in the mapping.
+    std::optional<History::Fingerprint> loadSnapshot(const std::string& path);
+
+    /// Compress the current graph into a Frozen view. Later changes need a new freeze().
+    /// since > 0 restricts it to that window: frequencies count only uses at or after since, and
+    /// variants and bases unused in the window are left out of the variant and base lists.
+    Frozen freeze(std::int64_t since = 0) const;
+
+    /// Uses at or after since (all uses when since <= 0); bases total their variants.
+    /// Commands without a timestamp never fall inside a window.
+    std::size_t getUsesSince(Vertex v, std::int64_t since) const;
+    /// Decayed recent use at now; bases total their variants.
+    double getHeat(Vertex v, std::int64_t now) const;
+    /// Newest command timestamp seen; 0 if the history has none.
+    std::int64_t getLatestTime() const;
+
+    /// Text of an interned base or flag.
+    std::string_view getSymbol(SymbolId id) const;
+    /// Display label, e.g., "<ls -al>", built from the symbol table.
+    std::string getLabel(Vertex v) const;
 
    private:
-    struct VariantUsage {
-        std::string base;               ///< For each base
-        std::set<std::string> flags;    ///< Collect a unique flag set
-        std::size_t earliestIndex;      ///< Save first time seen
-        std::size_t frequency = 0;      ///< And how often seen
+    static constexpr std::size_t kNoSuccessor = std::numeric_limits<std::size_t>::max();
+    static constexpr std::size_t kNotTouched = std::numeric_limits<std::size_t>::max();
+    /// Below this many commands per shard, a parallel build costs more than it saves.
+    static constexpr std::size_t kMinCommandsPerShard = 32 * 1024;
+
+    /// Variant identity: interned base plus its flag bits.
+    struct VariantKey {
+        SymbolId base = 0;
+        FlagSet flags;
+
+        bool operator==(const VariantKey& other) const = default;
+    };
+
+    struct VariantKeyHash {
+        std::size_t operator()(const VariantKey& key) const;
     };
 
     struct VariantItem {
@@ -52,29 +193,118 @@ class Graph {
         std::size_t flagCount;
     };
 
+    /// Per-base flag dictionary: bit position <-> interned flag.
+    struct FlagDictionary {
+        std::vector<SymbolId> flags;                     // bit -> flag
+        std::unordered_map<SymbolId, std::size_t> bits;  // flag -> bit
+
+        std::size_t bitFor(SymbolId flag);
+    };
+
+    /// Per-base state: central star, flag dictionary and its variants, kept sorted across appends.
+    struct Constellation {
+        Vertex vertex;
+        FlagDictionary dictionary;
+        std::vector<VariantItem> variantsByTime;  // chain order
+        std::vector<Vertex> variantsByFlagCount;  // layout order
+
+        std::size_t latestFirstSeen = 0;         // newest variant's firstSeenIndex
+        std::size_t appendedFrom = kNotTouched;  // first variantsByTime slot added by this append
+        bool needsRelink = false;                // time order of existing variants changed
+    };
+
     BoostGraph graph_;
-    std::unordered_map<std::string, Vertex> baseVertices_;     // base -> vertex
-    std::unordered_map<std::string, Vertex> variantVertices_;  // "key(base|f1,f2)" -> vertex
+    std::unordered_map<SymbolId, Constellation> constellations_;             // base -> its constellation
+    std::unordered_map<VariantKey, Vertex, VariantKeyHash> variantVertices_;  // (base, flags) -> vertex
+    std::vector<Activity> activity_;  // StarVertex::activity -> buckets
+    std::int64_t latestTime_ = 0;
+
+    std::shared_ptr<const char> snapshot_;   // mapped snapshot backing loaded symbol views
+    std::deque<std::string> symbolStorage_;  // stable backing for symbol views
+    std::vector<std::string_view> symbols_;  // id -> text
+    std::unordered_map<std::string_view, SymbolId> symbolIds_;
+    std::vector<SymbolId> touched_;  // bases folded into since their chains were last linked
+
+    /// Command position that created each vertex and symbol of a shard, in creation order.
+    struct CreationLog {
+        std::vector<std::size_t> vertices;
+        std::vector<std::size_t> symbols;
+    };
 
     void clearState();
 
-    static std::string makeKey(const std::string& base, const std::set<std::string>& flags);
-    static std::string makeLabel(const std::string& base, const std::set<std::string>& flags);
-    static bool isStrictSuperset(const std::set<std::string>& a, const std::set<std::string>& b);
+    /// Fold commands (all, or only those at positions) into the graph; chains of the bases they
+    /// touch are left for relinkTouched(). Logged positions are offset by firstPosition.
+    void foldCommands(const std::vector<Command>& commands,
+                      const std::vector<std::size_t>* positions,
+                      std::size_t firstPosition,
+                      CreationLog* log,
+                      std::vector<Vertex>& changed);
+    /// Link chains and re-index variants of every base folded into since the last call.
+    void relinkTouched(std::vector<Vertex>& changed);
+    /// Build per-base shards in parallel and stitch them in serial creation order.
+    void buildSharded(const std::vector<Command>& commands, std::size_t threads);
+    /// Move linked shards of an empty graph in, numbered as a serial fold in logged order would.
+    void mergeShards(std::vector<Graph>& shards, const std::vector<CreationLog>& logs);
 
-    static std::vector<std::string> extractBases(const std::vector<Command>& commands);
+    SymbolId intern(std::string_view text);
 
-    std::unordered_map<std::string, VariantUsage> collectVariantUsage(const std::vector<Command>& commands) const;
+    static bool isSubset(const std::uint64_t* a, const std::uint64_t* b, std::size_t words);
+    template <typename Visit>
+    static void forEachBit(const std::uint64_t* words, std::size_t count, Visit&& visit);
 
-    void addBaseVertices(const std::vector<std::string>& bases);
-    void addVariantVertices(const std::unordered_map<std::string, VariantUsage>& usageByKey);
-    void addBaseToVariantEdges();
+    Constellation& addBaseVertex(SymbolId base, std::vector<Vertex>& changed);
+    void addOrUpdateVariant(const Command& cmd, VariantKey& key, Constellation& constellation, std::vector<Vertex>& changed);
+    void recordUse(Vertex v, std::int64_t time);
 
-    std::vector<VariantItem> getVariantItemsForBase(const std::string& base) const;
-    void linkSpecializationChainForBase(const std::string& base);
+    void indexVariants(Constellation& constellation);
+    void linkSpecializationChainForBase(Constellation& constellation, std::vector<Vertex>& changed);
+    static std::vector<std::size_t> findChainSuccessors(const std::vector<std::uint64_t>& rows,
+                                                        const std::vector<std::size_t>& counts,
+                                                        std::size_t stride,
+                                                        std::size_t bitCount);
 
     static bool earlierByTime(const VariantItem& a, const VariantItem& b);
     static bool fewerFlagsThenEarlier(const VariantItem& a, const VariantItem& b);
 };
 
-}  // namespace stars
\ No newline at end of file
+/// Chains are linked and variants indexed once, in finish(), rather than per batch. Into an empty
+/// graph with threads > 1 (0 = one per hardware thread), bases are hashed to shard workers that
+/// fold each batch in parallel, and finish() stitches the shards with the serial numbering as
+/// build() does; otherwise batches are folded in place. Commands are only read during add().
+class Graph::Builder {
+   public:
+    Builder(Graph& graph, std::size_t threads);
+    ~Builder();
+
+    Builder(const Builder&) = delete;
+    Builder& operator=(const Builder&) = delete;
+
+    /// Fold a batch in. Rethrows a failure of any shard's fold; the builder then keeps throwing.
+    void add(const std::vector<Command>& commands);
+
+    /// Link what was added; the graph is complete afterwards. Without it the graph is left partial.
+    void finish();
+
+   private:
+    Graph& graph_;
+    std::size_t threads_;
+    std::vector<Graph> shards_;
+    std::vector<CreationLog> logs_;
+    std::vector<std::vector<Vertex>> changed_;           // per shard scratch, cleared per batch
+    std::vector<std::vector<std::size_t>> positions_;    // per shard: its commands in the batch
+    std::vector<std::uint32_t> shardOf_;                 // batch command -> shard
+    const std::vector<Command>* batch_ = nullptr;
+    std::size_t offset_ = 0;                             // position of the batch's first command
+    bool done_ = false;
+    std::vector<std::exception_ptr> errors_;             // per shard: first failure, for add()/finish()
+    std::unique_ptr<std::barrier<>> sync_;
+    std::vector<std::jthread> workers_;
+
+    void work(std::size_t t);
+    void foldShard(std::size_t t);
+    void stopWorkers();
+    void rethrowError() const;
+};
+
+}  // namespace stars
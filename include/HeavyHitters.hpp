@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace stars {
+
+/// Space-Saving summary of the most frequent keys in a stream, within a byte budget.
+/// Monitored counts overestimate by at most their error; any key whose true count exceeds
+/// getMaxError() is guaranteed to be monitored.
+class HeavyHitters {
+   public:
+    struct Entry {
+        std::string_view key;
+        std::uint64_t count = 0;  ///< Upper bound on the true count.
+        std::uint64_t error = 0;  ///< count - error is a lower bound on the true count.
+    };
+
+    explicit HeavyHitters(std::size_t budgetBytes);
+
+    HeavyHitters(const HeavyHitters&) = delete;
+    HeavyHitters& operator=(const HeavyHitters&) = delete;
+
+    /// Count one occurrence of key.
+    void offer(std::string_view key);
+
+    bool contains(std::string_view key) const;
+
+    /// Up to k monitored entries, highest count first (ties by key). Views live as long as the
+    /// key stays monitored.
+    std::vector<Entry> getTop(std::size_t k) const;
+
+    /// Occurrences offered so far.
+    std::uint64_t getTotal() const;
+
+    /// Upper bound on the true count of any unmonitored key.
+    std::uint64_t getMaxError() const;
+
+   private:
+    /// Approximate bytes per monitored key besides its text: heap slot, hash node, buckets.
+    static constexpr std::size_t kEntryOverhead = sizeof(Entry) + sizeof(std::string) + 6 * sizeof(void*);
+
+    struct Hash {
+        using is_transparent = void;
+        std::size_t operator()(std::string_view key) const { return std::hash<std::string_view>{}(key); }
+    };
+    using Index = std::unordered_map<std::string, std::size_t, Hash, std::equal_to<>>;  // key -> heap slot
+
+    /// Min-heap on count; each slot points back at its index node (stable across rehash).
+    struct Slot {
+        std::uint64_t count;
+        std::uint64_t error;
+        Index::value_type* node;
+    };
+
+    std::size_t budget_;
+    std::size_t used_ = 0;
+    std::uint64_t total_ = 0;
+    std::uint64_t maxEvicted_ = 0;
+    std::uint64_t dropped_ = 0;  // occurrences of keys too long for the whole budget
+    Index index_;
+    std::vector<Slot> heap_;
+
+    static std::size_t costOf(std::string_view key);
+    void evictMin();
+    void place(std::size_t pos, Slot slot);
+    void siftDown(std::size_t pos);
+    void siftUp(std::size_t pos);
+};
+
+}  // namespace stars
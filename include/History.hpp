@@ -1,21 +1,157 @@
 #pragma once
 
+#include <sys/types.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace stars {
 
-/// shell history lines
+/// shell history lines, exposed as views over a memory-mapped (or buffered) file
 class History {
    public:
+    /// Input encodings recognized from their magic bytes.
+    enum class Compression { None, Gzip, Zstd };
+
+    /// Line-scanning kernels; Auto is the widest the running CPU supports.
+    enum class ScanKernel { Auto, Scalar, Sse2, Avx2 };
+
+    /// Identity of the history bytes read so far, used to validate a Graph snapshot.
+    struct Fingerprint {
+        std::string path;                ///< Empty when the input cannot be cached (pipes).
+        std::uint64_t size = 0;          ///< Bytes covered.
+        std::int64_t modifiedNs = 0;     ///< mtime when read.
+        std::uint64_t tailHash = 0;      ///< Hash of the last kTailBytes before size.
+        std::uint64_t lineCount = 0;     ///< Lines covered, i.e. the next history index.
+        bool endsWithNewline = false;    ///< False if the last covered line may still grow.
+    };
+
+    static constexpr std::size_t kTailBytes = 4096;
 
-    History() = default;
+    History();
+    ~History();
 
+    History(const History&) = delete;
+    History& operator=(const History&) = delete;
+
+    /// Load lines from a file ("-" reads standard input): plain regular files are mapped, pipes,
+    /// devices and gzip/zstd input are decoded through a stream. Throws on error.
     void loadFromFile(const std::string& path);
-    const std::vector<std::string>& getLines() const;
+
+    /// Load only the lines past a snapshot's prefix when the file still starts with it (same tail
+    /// hash, only grown). Otherwise load the whole file and return false.
+    bool loadFromFile(const std::string& path, const Fingerprint& prefix);
+
+    /// Defer line scanning: loads map the input (or only open the stream) but leave getLines() empty
+    /// until readBatch().
+    void setStreaming(bool streaming);
+
+    /// Replace the current lines with the next unscanned slice of about maxBytes, cut after a newline,
+    /// numbered after the previous batch. Streamed input is decoded into a pooled chunk per batch.
+    /// Returns false once the input is exhausted.
+    bool readBatch(std::size_t maxBytes);
+
+    /// Rewind readBatch() to where streaming started after the last load, for another pass. Streamed
+    /// files are reopened; throws for standard input, pipes and other inputs that read only once.
+    void restartBatches();
+
+    /// Whether path names an input that cannot be read again from its start: standard input, or an
+    /// existing pipe, FIFO or device. Regular files (compressed too) and missing paths are not.
+    static bool isReadOnce(const std::string& path);
+
+    /// Compression of the last loaded input.
+    Compression getCompression() const;
+
+    /// Recognize gzip and zstd from the first bytes of an input.
+    static Compression detectCompression(std::string_view head);
+
+    /// Fingerprint of everything read so far.
+    Fingerprint getFingerprint() const;
+
+    /// Stable file name for caches derived from a history path.
+    static std::string getCacheName(const std::string& path);
+
+    /// Force the line-scanning kernel of every History, e.g. to compare kernels in tests. Returns
+    /// false, changing nothing, when the running CPU lacks it.
+    static bool setScanKernel(ScanKernel kernel);
+
+    /// 64-bit FNV-1a.
+    static std::uint64_t hashBytes(std::string_view bytes);
+
+    /// Line views; valid while this History lives and until the next load, readBatch() or readAppended().
+    const std::vector<std::string_view>& getLines() const;
+
+    /// Buffer behind getLines(); holding it keeps those views valid past the next read.
+    std::shared_ptr<const char> getData() const;
+
+    /// Per-line flag set by the scanner for empty and '#' lines.
+    const std::vector<bool>& getSkippable() const;
+
+    /// Global history index of getLines()[0]; non-zero after readAppended().
+    std::size_t getFirstLineNumber() const;
+
+    /// Start watching the loaded file (and its directory, for rotation) with inotify. Throws on error,
+    /// and for standard input or compressed files.
+    void follow();
+
+    /// Block until the watched file is written, truncated, replaced or moved.
+    void waitForChange();
+
+    /// Same, giving up after timeout. Returns whether the file changed.
+    bool waitForChange(std::chrono::milliseconds timeout);
+
+    /// Replace the current lines with the complete lines appended since the last read, reading only
+    /// the new bytes. A truncated file restarts from its current end; a rotated one from its start,
+    /// after the lines still written to the old file when following it.
+    /// Returns the number of new lines.
+    std::size_t readAppended();
 
    private:
-    std::vector<std::string> rawLines_;
+    struct Decoder;
+    struct ChunkPool;
+
+    std::shared_ptr<const char> data_;  ///< Mapping or owned buffer backing every line view.
+    std::size_t size_ = 0;
+    std::size_t dataOffset_ = 0;  ///< File offset of data_[0].
+    std::vector<std::string_view> lines_;
+    std::vector<bool> skippable_;
+    std::size_t firstLineNumber_ = 0;
+
+    std::string path_;
+    std::size_t offset_ = 0;  ///< Bytes consumed from the current file.
+    dev_t device_ = 0;
+    ino_t inode_ = 0;
+    std::int64_t modifiedNs_ = 0;
+    bool regular_ = false;
+    bool rereadable_ = false;  ///< A regular file, which restartBatches() may reopen.
+
+    bool streaming_ = false;
+    std::size_t scanOffset_ = 0;  ///< Next unscanned byte of data_ in streaming mode.
+    std::size_t streamStart_ = 0;
+    std::size_t streamFirstLine_ = 0;
+
+    Compression compression_ = Compression::None;
+    std::unique_ptr<Decoder> decoder_;  ///< Open stream of unmapped input while streaming.
+    std::shared_ptr<ChunkPool> pool_;
+    std::string carry_;                 ///< Decoded bytes after the last newline of the previous batch.
+
+    int watchFd_ = -1;
+    int fileWatch_ = -1;
+    int fileFd_ = -1;  ///< The followed file, kept open to drain it after a rotation.
+    int directoryWatch_ = -1;
+
+    static std::shared_ptr<const char> mapFile(int fd, std::size_t size);
+    static std::shared_ptr<const char> readAll(Decoder& decoder, std::size_t& size);
+    bool readStreamBatch(std::size_t maxBytes);
+    bool openFile(const std::string& path, const Fingerprint* prefix);
+    void scanLines(std::size_t from = 0, std::size_t to = std::string::npos);
+    void watchFile();
+    bool readWatchEvents();
 };
 
 }  // namespace stars
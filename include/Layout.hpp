@@ -1,8 +1,10 @@
 #pragma once
 
+#include <chrono>
 #include <cstddef>
-#include <unordered_map>
+#include <cstdint>
 #include <utility>
+#include <vector>
 
 #include "Graph.hpp"
 
@@ -15,27 +17,99 @@ class Layout {
         std::size_t y;
     };
 
+    /// How compute() places stars.
+    enum class Mode {
+        Packed,  ///< Constellations arranged on slot rows and packed side by side.
+        Force,   ///< Force-directed relaxation (Barnes-Hut) of the packed layout, snapped to cells.
+    };
+
     Layout() = default;
 
-    /// Compute positions for all vertices, stacked vertically by base.
-    void compute(const Graph& graph,
+    void setMode(Mode mode);
+    Mode getMode() const;
+
+    /// Force mode stops after iterations steps or once time has passed, whichever comes first.
+    void setForceBudget(std::size_t iterations, std::chrono::milliseconds time);
+
+    /// Force mode worker threads; 0 means one per hardware thread.
+    void setThreads(std::size_t threads);
+
+    /// Compute positions for the most used constellations, packed side by side into the canvas
+    /// without overlapping stars or labels. Buffers are kept between calls, so re-laying out a graph
+    /// of the same size allocates nothing.
+    void compute(const Graph::Frozen& graph,
                  std::size_t width,
                  std::size_t height,
                  std::size_t maxConstellations);
 
-    /// Get position for a graph::vertex (if present).
+    /// Get position for a graph::vertex ({0, 0} unless placed).
     Position getPosition(Graph::Vertex v) const;
 
+    /// Whether the last compute() gave v a position; stars of hidden constellations are not placed.
+    bool isPlaced(Graph::Vertex v) const;
+
     /// Return computed canvas size.
     std::pair<std::size_t, std::size_t> getCanvasSize() const;
 
-    /// Return all assigned positions.
-    const std::unordered_map<Graph::Vertex, Position>& getPositions() const;
+    /// Positions indexed by vertex; meaningful only where isPlaced().
+    const std::vector<Position>& getPositions() const;
 
    private:
-    std::unordered_map<Graph::Vertex, Position> positions_;
+    /// A star in constellation-local coordinates.
+    struct LocalStar {
+        Graph::Vertex vertex;
+        std::size_t x;
+        std::ptrdiff_t row;  ///< Relative to the base row.
+    };
+
+    /// Extent of the stars and labels of one arranged constellation.
+    struct Box {
+        std::size_t width = 0;
+        std::size_t height = 0;
+        std::ptrdiff_t top = 0;  ///< Row of the box's first line, relative to the base row.
+    };
+
+    /// Barnes-Hut quadtree cell over force-mode bodies; sums over mass give the centre of mass.
+    struct QuadNode {
+        float cx, cy, half;       ///< Square bounds.
+        float sx, sy, mass;       ///< Coordinate sums and body count below.
+        std::int32_t child = -1;  ///< First of four children; -1 for a leaf.
+        std::int32_t body = -1;   ///< A leaf's only body; -1 when empty or merged at full depth.
+    };
+
+    /// Below this many bodies per worker, threads cost more than they save.
+    static constexpr std::size_t kMinBodiesPerThread = 1024;
+
+    Mode mode_ = Mode::Packed;
+    std::size_t forceIterations_ = 300;
+    std::chrono::milliseconds forceTime_{30};
+    std::size_t threads_ = 0;
+
+    std::vector<Position> positions_;
+    std::vector<std::uint64_t> placed_;     // bit v set once positions_[v] is assigned
+    std::vector<Graph::Vertex> bases_;      // scratch: constellations by use
+    std::vector<LocalStar> local_;          // scratch: the constellation being arranged
+    std::vector<std::uint64_t> occupancy_;  // scratch: one bit per cell of each slot row
+    std::vector<std::size_t> skyline_;      // scratch: first free row of each canvas column
+    std::vector<std::size_t> window_;       // scratch: sliding-maximum deque over skyline_
+
+    // Force-mode scratch, indexed by body (a star of a shown constellation). y runs in half rows so
+    // that distances look round on roughly 1:2 terminal cells.
+    std::vector<Graph::Vertex> bodies_;
+    std::vector<std::uint32_t> bodyOf_;  // vertex -> body
+    std::vector<float> px_, py_, dx_, dy_;
+    std::vector<std::uint32_t> adjacencyOffsets_, adjacency_;
+    std::vector<QuadNode> tree_;
     std::size_t canvasWidth_ = 0;
     std::size_t canvasHeight_ = 0;
+
+    void place(Graph::Vertex v, Position p);
+    Box arrange(const Graph::Frozen& graph, Graph::Vertex base, std::size_t width, std::size_t slotsPerSide);
+    bool findSpot(std::size_t width, std::size_t height, std::size_t& x, std::size_t& y);
+    void relax(const Graph::Frozen& graph);
+    void buildTree();
+    void accumulateForces(std::size_t begin, std::size_t end, float k);
+    void snap(const Graph::Frozen& graph);
 };
 
 }  // namespace stars
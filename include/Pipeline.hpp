@@ -0,0 +1,216 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <new>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Command.hpp"
+#include "Graph.hpp"
+#include "History.hpp"
+
+namespace stars {
+
+/// Streaming ingestion: a reader slices the history into batches, a pool of parsers tokenizes them
+/// and the calling thread folds them into the graph in history order. At most maxInFlight batches
+/// exist at once, so memory is bounded by the graph (distinct variants) rather than history length.
+class Pipeline {
+   public:
+    /// Bounded lock-free multi-producer/multi-consumer ring (Vyukov). Each cell carries a sequence
+    /// number telling producers and consumers whose turn it is; blocking calls sleep on that number.
+    template <typename T>
+    class BoundedQueue {
+       public:
+        /// Capacity is rounded up to a power of two.
+        explicit BoundedQueue(std::size_t capacity);
+
+        BoundedQueue(const BoundedQueue&) = delete;
+        BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+        /// Move value in unless the queue is full.
+        bool tryPush(T& value);
+        /// Move the oldest value out unless the queue is empty.
+        bool tryPop(T& value);
+
+        /// Block while full.
+        void push(T value);
+        /// Block while empty.
+        T pop();
+
+       private:
+        struct alignas(64) Cell {
+            std::atomic<std::size_t> sequence;
+            T value;
+        };
+
+        std::unique_ptr<Cell[]> cells_;
+        std::size_t mask_;
+        alignas(64) std::atomic<std::size_t> enqueuePos_{0};
+        alignas(64) std::atomic<std::size_t> dequeuePos_{0};
+    };
+
+    /// Aggregator stage: sees each parsed batch once, in history order, and may consume it.
+    using Consumer = std::function<void(std::vector<Command>&)>;
+
+    /// parsers = 0 uses one per hardware thread.
+    explicit Pipeline(std::size_t parsers = 0,
+                      std::size_t batchBytes = 256 * 1024,
+                      std::size_t maxInFlight = 0);
+
+    /// Stream every unread line of a history loaded with setStreaming(true) into graph through a
+    /// Graph::Builder, exactly as one append of all of them would; an empty graph is built in as many
+    /// base shards as there are parsers. The format (bash or zsh) is detected from the first batch.
+    /// Returns the number of commands.
+    /// Rethrows the first error raised by any stage.
+    std::size_t run(History& history, Graph& graph);
+
+    /// Same stages with a custom aggregator: consume sees each parsed batch once, in history order.
+    /// Returns the number of commands parsed.
+    std::size_t run(History& history, const Consumer& consume);
+
+    /// Bounded-memory mode for huge histories: a first pass ranks bases and variants with
+    /// HeavyHitters summaries sharing budgetBytes, a second pass (restartBatches()) feeds the graph
+    /// only commands of the k most frequent bases whose variant is still monitored, with exact counts.
+    /// Returns the number of commands kept.
+    std::size_t runTopK(History& history, Graph& graph, std::size_t k, std::size_t budgetBytes);
+
+    /// One galaxy from many histories (bash or zsh, detected per file). The parser pool reads every
+    /// file in small batches, a few batches ahead, and the calling thread k-way merges their commands
+    /// by timestamp (ties by path order) into one global index order. Files whose own timestamps go
+    /// backwards keep their order. Returns the number of commands.
+    std::size_t runMerged(const std::vector<std::string>& paths, Graph& graph);
+    std::size_t runMerged(const std::vector<std::string>& paths, const Consumer& consume);
+
+    /// runTopK over the merged histories.
+    std::size_t runMergedTopK(const std::vector<std::string>& paths, Graph& graph, std::size_t k,
+                              std::size_t budgetBytes);
+
+    /// Time in effect after the last run (its last "#<epoch>" line), to continue stamping appends.
+    std::int64_t getLastTimestamp() const;
+
+    /// Format detected by the last run, to parse appends the same way.
+    Command::Format getFormat() const;
+
+   private:
+    /// Parsed batches kept ahead of the merge per file.
+    static constexpr std::size_t kMergeDepth = 2;
+    /// Per-file batches shrink with the number of files, down to this size.
+    static constexpr std::size_t kMinMergeBatchBytes = 16 * 1024;
+    /// Merged commands handed to the consumer at once.
+    static constexpr std::size_t kMergeBatchCommands = 4096;
+
+    /// Raw lines of one slice; views point into data (the History mapping or a decoded chunk).
+    struct Batch {
+        std::size_t sequence = 0;
+        std::size_t firstIndex = 0;
+        std::int64_t timestamp = 0;  ///< Time in effect before lines[0].
+        bool continued = false;      ///< zsh: lines[0] continues the previous batch's last entry.
+        std::shared_ptr<const char> data;
+        std::vector<std::string_view> lines;
+        std::vector<bool> skippable;
+    };
+
+    /// Parsed commands of one slice with the arena holding their rewritten tokens.
+    struct Parsed {
+        std::size_t sequence = 0;
+        std::shared_ptr<const char> data;
+        Command::Arena arena;
+        std::vector<Command> commands;
+    };
+
+    std::size_t parsers_;
+    std::size_t batchBytes_;
+    std::size_t maxInFlight_;
+    std::int64_t lastTimestamp_ = 0;
+    Command::Format format_ = Command::Format::Bash;
+
+    /// Two passes of runTopK; pass(consume) streams the whole input once. The graph is built by
+    /// threads shard workers.
+    static std::size_t topK(const std::function<void(const Consumer&)>& pass, Graph& graph, std::size_t k,
+                            std::size_t budgetBytes, std::size_t threads);
+};
+
+template <typename T>
+Pipeline::BoundedQueue<T>::BoundedQueue(std::size_t capacity) {
+    std::size_t size = 2;
+    while (size < capacity) size *= 2;
+    cells_ = std::make_unique<Cell[]>(size);
+    mask_ = size - 1;
+    for (std::size_t i = 0; i < size; ++i) cells_[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+template <typename T>
+bool Pipeline::BoundedQueue<T>::tryPush(T& value) {
+    std::size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+    for (;;) {
+        Cell& cell = cells_[pos & mask_];
+        const std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+        const auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+        if (diff == 0) {
+            if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                cell.value = std::move(value);
+                cell.sequence.store(pos + 1, std::memory_order_release);
+                cell.sequence.notify_all();
+                return true;
+            }
+        } else if (diff < 0) {
+            return false;  // Cell still holds the value from one lap ago: full.
+        } else {
+            pos = enqueuePos_.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+template <typename T>
+bool Pipeline::BoundedQueue<T>::tryPop(T& value) {
+    std::size_t pos = dequeuePos_.load(std::memory_order_relaxed);
+    for (;;) {
+        Cell& cell = cells_[pos & mask_];
+        const std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+        const auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos + 1);
+        if (diff == 0) {
+            if (dequeuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                value = std::move(cell.value);
+                cell.sequence.store(pos + mask_ + 1, std::memory_order_release);
+                cell.sequence.notify_all();
+                return true;
+            }
+        } else if (diff < 0) {
+            return false;  // Producer has not filled this cell yet: empty.
+        } else {
+            pos = dequeuePos_.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+template <typename T>
+void Pipeline::BoundedQueue<T>::push(T value) {
+    while (!tryPush(value)) {
+        // Sleep until the consumer of the blocking cell advances its sequence.
+        const std::size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+        Cell& cell = cells_[pos & mask_];
+        const std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+        if (sequence < pos) cell.sequence.wait(sequence, std::memory_order_acquire);
+    }
+}
+
+template <typename T>
+T Pipeline::BoundedQueue<T>::pop() {
+    T value;
+    while (!tryPop(value)) {
+        // Sleep until the producer of the blocking cell publishes into it.
+        const std::size_t pos = dequeuePos_.load(std::memory_order_relaxed);
+        Cell& cell = cells_[pos & mask_];
+        const std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+        if (sequence < pos + 1) cell.sequence.wait(sequence, std::memory_order_acquire);
+    }
+    return value;
+}
+
+}  // namespace stars
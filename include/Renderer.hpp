@@ -1,6 +1,10 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
 #include "Graph.hpp"
@@ -11,30 +15,110 @@ namespace stars {
 class Renderer {
    public:
 
+    /// What a framebuffer cell shows; animation treats each kind differently.
+    enum class Ink : std::uint8_t {
+        Space,
+        Star,
+        Label,
+        Connector,
+    };
+
+    struct Cell {
+        char glyph = ' ';
+        Ink ink = Ink::Space;
+        std::uint8_t heat = 0;  ///< 0 uncoloured; 1..255 from least to most used.
+    };
+
+    /// Colours the heatmap is drawn in.
+    enum class Palette {
+        None,       ///< Plain text.
+        Ansi256,    ///< The 6x6x6 cube of 256-colour terminals.
+        TrueColor,  ///< 24-bit RGB.
+    };
+
+    /// SGR escape back to the terminal's default colour.
+    static constexpr std::string_view kResetPen = "\x1b[0m";
+
    Renderer() = default;
 
-    /// Render entire graph to a string buffer.
-    std::string render(const Graph& graph, const Layout& layout);
+    /// Edge rasterization worker threads; 0 means one per hardware thread.
+    void setThreads(std::size_t threads);
+
+    /// Colour stars, labels and connectors by use frequency (default None).
+    void setPalette(Palette palette);
+
+    /// SGR escape selecting the colour of heat; empty for heat 0 or without a palette.
+    std::string_view getPen(std::uint8_t heat) const;
+
+    /// Render entire graph into the framebuffer and return it serialized as rows of text. The view
+    /// stays valid until the next render(); at an unchanged canvas size nothing is allocated.
+    std::string_view render(const Graph::Frozen& graph, const Layout& layout);
+
+    /// Draw into the framebuffer only, for callers that serialize it themselves.
+    void draw(const Graph::Frozen& graph, const Layout& layout);
+
+    /// Cells of the last draw, row-major.
+    const std::vector<Cell>& getFrame() const;
+
+    /// Width and height of the last draw.
+    std::pair<std::size_t, std::size_t> getCanvasSize() const;
 
    private:
    
    /*
-                string(W)
+                 frame_ (W x H cells, row-major)
           +-------------------+
-      v   |   *               |
-      e   |   | \             |
-      c   |   |  *            |
-      t   |   | / \           |
-      o   |   *    *          |
-      r   |                   |
-     (H)  |                   |
+          |   *               |  row 0: frame_[0 .. W)
+          |   | \             |  row 1: frame_[W .. 2W)
+          |   |  *            |
+          |   | / \           |
+          |   *    *          |
+          |                   |
+          |                   |
           +-------------------+
    */
-    std::vector<std::string> canvas;
+    std::vector<Cell> frame_;
+    std::size_t width_ = 0;
+    std::size_t height_ = 0;
+    std::string output_;  ///< Rows of frame_ with a newline each, rewritten in place per render.
+    Palette palette_ = Palette::None;
+    std::vector<std::string> pens_;    ///< SGR escape per heat, built by setPalette().
+    std::vector<std::uint8_t> heat_;   ///< Heat per vertex of the last draw.
+
+    /// Screen tiles edges are binned into; each tile is rasterized by one worker.
+    static constexpr std::size_t kTileWidth = 64;
+    static constexpr std::size_t kTileHeight = 16;
+    /// Fewer edges per worker than this are drawn on the calling thread.
+    static constexpr std::size_t kMinEdgesPerThread = 2048;
+
+    /// Half-open cell rectangle [x0, x1) x [y0, y1).
+    struct Rect {
+        std::size_t x0, y0, x1, y1;
+    };
+
+    struct Segment {
+        Layout::Position a, b;
+        std::uint8_t heat;
+    };
+
+    std::size_t threads_ = 0;
+    std::vector<Segment> segments_;            ///< Edges to draw, in drawing order.
+    std::vector<std::uint32_t> tileOffsets_;   ///< Per tile, start of its run in tileSegments_.
+    std::vector<std::uint32_t> tileSegments_;  ///< Segment indices grouped by tile, in drawing order.
+
+    Cell* row(std::size_t y);
+
+    void drawStar(const Layout::Position& p, std::string_view label, std::uint8_t heat);
+
+    /// Draw every segment: serially over the whole canvas, or binned into tiles drawn concurrently.
+    /// Either way each cell keeps the glyph of the first segment reaching it.
+    void drawSegments();
 
-    void drawStar(const Layout::Position& p, const std::string& label);
+    /// Plot the cells of the segment that fall inside clip, skipping cells already drawn.
+    void drawConnector(const Segment& segment, const Rect& clip);
 
-    void drawConnector(const Layout::Position& a, const Layout::Position& b);
+    /// Heat levels of the placed vertices: log-scaled frequency relative to the most used one.
+    void computeHeat(const Graph::Frozen& graph, const Layout& layout);
 };
 
 }  // namespace stars
@@ -2,6 +2,7 @@
 
 #include <cstddef>
 #include <string>
+#include <string_view>
 
 namespace stars {
 
@@ -12,9 +13,26 @@ class Terminal {
 
     static std::pair<std::size_t, std::size_t> getSize();
 
-    static void write(const std::string& buffer);
+    static void write(std::string_view buffer);
+
+    /// Colour depth standard output supports, in bits: 24 when COLORTERM says truecolor, 8 for a
+    /// 256-colour TERM, else (or when not a terminal) 0.
+    static int getColorDepth();
+
+    /// Home the cursor and clear the screen before a redraw.
+    static void clear();
+
+    /// Hide the cursor for animation; the first frame clears the screen.
+    static void beginAnimation();
+
+    /// Show the cursor again below a height-row animation.
+    static void endAnimation(std::size_t height);
 
     static std::string getHistoryPath();
+
+    /// Per-user cache directory ($XDG_CACHE_HOME/stars or ~/.cache/stars), created on demand.
+    /// Empty when neither variable is set or the directory cannot be created.
+    static std::string getCacheDirectory();
 };
 
 }  // namespace stars
@@ -0,0 +1,148 @@
+#include "Animator.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdlib>
+
+using namespace stars;
+
+namespace {
+
+/// Stable pseudo-random value per scene cell, so effects stay with a cell while the sky pans.
+std::uint32_t cellHash(std::size_t x, std::size_t y) {
+    std::uint32_t h = static_cast<std::uint32_t>(x) * 0x9e3779b1u ^ static_cast<std::uint32_t>(y) * 0x85ebca77u;
+    h ^= h >> 15;
+    h *= 0x2c1b3c6du;
+    h ^= h >> 12;
+    return h;
+}
+
+/// Star glyph at a point of its twinkle: brighten, dim, brighten, back to '*'.
+char twinkle(std::int64_t phase, std::int64_t length) {
+    if (phase >= length) return '*';
+    static constexpr char kSteps[] = {'+', '.', '+'};
+    return kSteps[phase * 3 / length];
+}
+
+}  // namespace
+
+std::string_view Animator::frame(const Renderer& scene, std::chrono::milliseconds elapsed) {
+    output_.clear();
+    auto [W, H] = scene.getCanvasSize();
+    if (W != width_ || H != height_ || front_.size() != W * H) {
+        // Unknown screen: clear it, and diff against the blank screen that leaves.
+        width_ = W;
+        height_ = H;
+        front_.assign(W * H, Renderer::Cell{});
+        back_.resize(W * H);
+        output_ += "\x1b[H\x1b[2J";
+    }
+
+    compose(scene, elapsed.count());
+    emitChanges(scene);
+    front_.swap(back_);
+    return output_;
+}
+
+void Animator::reset() {
+    width_ = 0;
+    height_ = 0;
+    front_.clear();
+}
+
+const std::vector<Renderer::Cell>& Animator::getScreen() const {
+    return front_;
+}
+
+/// Fill back_ with the scene panned left by the elapsed columns, stars twinkling and connectors
+/// thinned out to the current fade level.
+void Animator::compose(const Renderer& scene, std::int64_t millis) {
+    if (width_ == 0) return;
+    const auto& cells = scene.getFrame();
+    const auto pan = static_cast<std::size_t>(millis / kPanMillis) % width_;
+
+    // Triangle wave between kMinFade and 256.
+    const std::int64_t half = kFadePeriodMillis / 2;
+    const std::int64_t t = millis % kFadePeriodMillis;
+    const auto fade = static_cast<std::uint32_t>(kMinFade + (256 - kMinFade) * std::abs(t - half) / half);
+
+    for (std::size_t y = 0; y < height_; ++y) {
+        const Renderer::Cell* row = cells.data() + y * width_;
+        Renderer::Cell* out = back_.data() + y * width_;
+        for (std::size_t x = 0; x < width_; ++x) {
+            const std::size_t sx = x + pan < width_ ? x + pan : x + pan - width_;
+            const Renderer::Cell& cell = row[sx];
+            char glyph = cell.glyph;
+            switch (cell.ink) {
+                case Renderer::Ink::Star: {
+                    const std::int64_t phase = (millis + cellHash(sx, y)) % kTwinklePeriodMillis;
+                    glyph = twinkle(phase, kTwinkleMillis);
+                    break;
+                }
+                case Renderer::Ink::Connector:
+                    if ((cellHash(sx, y) & 0xff) >= fade) glyph = ' ';
+                    break;
+                default:
+                    break;
+            }
+            // Colour is invisible on a space, so blanks compare equal whatever drew them.
+            out[x] = {glyph, cell.ink, glyph == ' ' ? std::uint8_t{0} : cell.heat};
+        }
+    }
+}
+
+/// Append the cursor moves and runs that turn front_ into back_. Runs separated by a few unchanged
+/// cells are merged by rewriting those cells, which is cheaper than moving over them. The pen starts
+/// and ends each frame at the default colour.
+void Animator::emitChanges(const Renderer& scene) {
+    std::uint8_t pen = 0;
+    auto put = [&](const Renderer::Cell& cell) {
+        if (cell.glyph != ' ' && cell.heat != pen) {
+            output_ += cell.heat != 0 ? scene.getPen(cell.heat) : Renderer::kResetPen;
+            pen = cell.heat;
+        }
+        output_ += cell.glyph;
+    };
+    auto same = [](const Renderer::Cell& a, const Renderer::Cell& b) {
+        return a.glyph == b.glyph && a.heat == b.heat;
+    };
+
+    for (std::size_t y = 0; y < height_; ++y) {
+        const Renderer::Cell* before = front_.data() + y * width_;
+        const Renderer::Cell* after = back_.data() + y * width_;
+        std::size_t cursor = width_;  // Column the cursor is at on this row; width_ when elsewhere.
+        for (std::size_t x = 0; x < width_; ++x) {
+            if (same(before[x], after[x])) continue;
+            const bool rewrite =
+                cursor < x && x - cursor <= kMaxRewrite &&
+                std::all_of(after + cursor, after + x, [&](const auto& c) { return c.glyph == ' ' || c.heat == pen; });
+            if (rewrite) {
+                std::for_each(after + cursor, after + x, put);
+            } else if (cursor < x) {
+                output_ += "\x1b[";
+                appendNumber(x - cursor);
+                output_ += 'C';
+            } else if (cursor != x) {
+                moveTo(x, y);
+            }
+            put(after[x]);
+            // Terminals disagree on where the cursor sits after the last column, so forget it.
+            cursor = x + 1 < width_ ? x + 1 : width_;
+        }
+    }
+    if (pen != 0) output_ += Renderer::kResetPen;
+}
+
+void Animator::moveTo(std::size_t x, std::size_t y) {
+    output_ += "\x1b[";
+    appendNumber(y + 1);
+    output_ += ';';
+    appendNumber(x + 1);
+    output_ += 'H';
+}
+
+void Animator::appendNumber(std::size_t value) {
+    char digits[20];
+    const auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    output_.append(digits, result.ptr);
+}
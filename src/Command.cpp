@@ -1,80 +1,295 @@
 #include "Command.hpp"
 
 #include <algorithm>
-#include <boost/tokenizer.hpp>
-#include <cctype>
+#include <charconv>
+#include <iterator>
+#include <thread>
 
 using namespace stars;
 
-Command::Command(): original(), base(), flags(), args(), index(0) {}
+namespace {
+
+bool isBlank(char c) { return c == ' ' || c == '\t'; }
+
+bool isTokenBreak(char c) { return isBlank(c) || c == '"' || c == '\'' || c == '\\'; }
+
+}  // namespace
+
+char* Command::Arena::reserve(std::size_t n) {
+    if (n > available_) {
+        const std::size_t size = std::max(n, kBlockSize);
+        blocks_.push_back(std::make_unique<char[]>(size));
+        cursor_ = blocks_.back().get();
+        available_ = size;
+    }
+    return cursor_;
+}
+
+std::string_view Command::Arena::commit(std::size_t n) {
+    std::string_view out(cursor_, n);
+    cursor_ += n;
+    available_ -= n;
+    return out;
+}
+
+void Command::Arena::adopt(Arena&& other) {
+    // Only the block list is merged; this arena keeps filling its own current block.
+    blocks_.insert(blocks_.end(), std::make_move_iterator(other.blocks_.begin()),
+                   std::make_move_iterator(other.blocks_.end()));
+    other.blocks_.clear();
+    other.cursor_ = nullptr;
+    other.available_ = 0;
+}
+
+Command::Command(): original(), base(), flags(), args(), index(0), timestamp(0) {}
+
+std::vector<Command> Command::parseLines(const std::vector<std::string_view>& lines,
+                                         Arena& arena,
+                                         const std::vector<bool>& skippable,
+                                         std::size_t firstIndex,
+                                         std::size_t threads,
+                                         std::int64_t timestamp) {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = std::min(threads, std::max<std::size_t>(1, lines.size() / kMinLinesPerThread));
 
-std::vector<Command> Command::parseLines(const std::vector<std::string>& lines) {
     std::vector<Command> out;
-    out.reserve(lines.size());
+    if (threads == 1) {
+        out.reserve(lines.size());
+        parseRange(lines, skippable, 0, lines.size(), firstIndex, timestamp, arena, out);
+        return out;
+    }
+
+    // Each worker parses one contiguous chunk into its own arena and vector; indices depend only on
+    // line position, so chunks concatenated in order equal the serial result. The time in effect at
+    // a chunk's start is only known once earlier chunks are done, so commands before its first epoch
+    // line are stamped during the gather.
+    struct Chunk {
+        Arena arena;
+        std::vector<Command> commands;
+        std::size_t offset = 0;       // first slot in out
+        std::size_t unstamped = 0;    // leading commands parsed before the chunk's first epoch line
+        std::int64_t endTime = 0;     // time in effect at the chunk's end, 0 if it has no epoch line
+        std::int64_t startTime = 0;   // time in effect at the chunk's start
+    };
+    std::vector<Chunk> chunks(threads);
+    const std::size_t step = (lines.size() + threads - 1) / threads;
+
+    auto forEachChunk = [&](auto&& work) {
+        std::vector<std::jthread> workers;
+        workers.reserve(threads - 1);
+        for (std::size_t t = 1; t < threads; ++t) workers.emplace_back([&work, t] { work(t); });
+        work(0);
+    };
+
+    forEachChunk([&](std::size_t t) {
+        const std::size_t begin = std::min(lines.size(), t * step);
+        const std::size_t end = std::min(lines.size(), begin + step);
+        chunks[t].commands.reserve(end - begin);
+        chunks[t].unstamped = parseRange(lines, skippable, begin, end, firstIndex, chunks[t].endTime,
+                                         chunks[t].arena, chunks[t].commands);
+    });
+
+    std::size_t total = 0;
+    std::int64_t carry = timestamp;
+    for (auto& chunk : chunks) {
+        chunk.offset = total;
+        total += chunk.commands.size();
+        chunk.startTime = carry;
+        if (chunk.endTime != 0) carry = chunk.endTime;
+    }
+
+    // Commands are not trivially relocatable (inline token storage), so the gather is parallel too.
+    out.resize(total);
+    forEachChunk([&](std::size_t t) {
+        Chunk& chunk = chunks[t];
+        for (std::size_t i = 0; i < chunk.unstamped; ++i) chunk.commands[i].timestamp = chunk.startTime;
+        std::move(chunk.commands.begin(), chunk.commands.end(), out.begin() + static_cast<std::ptrdiff_t>(chunk.offset));
+    });
 
-    std::size_t idx = 0;
-    for (const auto& line : lines) {
-        if (isSkippableLine(line)) {
-            ++idx;
+    for (auto& chunk : chunks) arena.adopt(std::move(chunk.arena));
+    return out;
+}
+
+std::size_t Command::parseRange(const std::vector<std::string_view>& lines,
+                                const std::vector<bool>& skippable,
+                                std::size_t begin,
+                                std::size_t end,
+                                std::size_t firstIndex,
+                                std::int64_t& timestamp,
+                                Arena& arena,
+                                std::vector<Command>& out) {
+    // Use the scanner's bulk classification when it covers every line.
+    const bool classified = skippable.size() == lines.size();
+    const std::size_t first = out.size();
+    std::size_t unstamped = kNotCounted;
+
+    for (std::size_t idx = begin; idx < end; ++idx) {
+        const std::string_view line = lines[idx];
+        if (classified ? skippable[idx] : isSkippableLine(line)) {
+            std::int64_t time = 0;
+            if (parseTimestamp(line, time)) {
+                if (unstamped == kNotCounted) unstamped = out.size() - first;
+                timestamp = time;
+            }
             continue;
         }
 
-        auto tokens = tokenizeBoost(line);
-
-        Command cmd;
+        Command& cmd = out.emplace_back();
         cmd.original = line;
-        cmd.base = extractBase(tokens);
-        cmd.flags = extractFlagsSorted(tokens);
-        cmd.args = extractArgs(tokens);
-        cmd.index = idx;
+        cmd.index = firstIndex + idx;
+        cmd.timestamp = timestamp;
+        tokenize(line, arena, cmd);
+    }
+    return unstamped == kNotCounted ? out.size() - first : unstamped;
+}
+
+bool Command::parseTimestamp(std::string_view line, std::int64_t& time) {
+    if (line.size() < 2 || line[0] != '#' || line[1] < '0' || line[1] > '9') return false;
+    // Digits only, and rejected rather than wrapped past INT64_MAX.
+    std::int64_t value = 0;
+    const char* end = line.data() + line.size();
+    const auto [ptr, ec] = std::from_chars(line.data() + 1, end, value);
+    if (ec != std::errc{} || ptr != end) return false;
+    time = value;
+    return true;
+}
 
-        out.push_back(std::move(cmd));
-        ++idx;
+std::int64_t Command::findLastTimestamp(const std::vector<std::string_view>& lines, std::int64_t fallback) {
+    for (std::size_t i = lines.size(); i-- > 0;) {
+        std::int64_t time = 0;
+        if (parseTimestamp(lines[i], time)) return time;
     }
+    return fallback;
+}
+
+Command::Format Command::detectFormat(const std::vector<std::string_view>& lines) {
+    for (std::string_view line : lines) {
+        if (line.empty()) continue;
+        std::int64_t time = 0;
+        std::string_view command;
+        return parseZshEntry(line, time, command) ? Format::Zsh : Format::Bash;
+    }
+    return Format::Bash;
+}
 
+std::vector<Command> Command::parseZshLines(const std::vector<std::string_view>& lines,
+                                            Arena& arena,
+                                            std::size_t firstIndex,
+                                            bool& continued) {
+    std::vector<Command> out;
+    out.reserve(lines.size());
+    for (std::size_t idx = 0; idx < lines.size(); ++idx) {
+        const std::string_view line = lines[idx];
+        const bool continuation = continued;
+        continued = !line.empty() && line.back() == '\\';
+        if (continuation) continue;
+
+        std::int64_t time = 0;
+        std::string_view text = line;
+        if (!parseZshEntry(line, time, text)) time = 0;
+        if (text.empty()) continue;
+
+        Command& cmd = out.emplace_back();
+        cmd.original = text;
+        cmd.index = firstIndex + idx;
+        cmd.timestamp = time;
+        tokenize(text, arena, cmd);
+    }
     return out;
 }
 
-bool Command::isSkippableLine(const std::string& line) {
+bool Command::parseZshEntry(std::string_view line, std::int64_t& time, std::string_view& command) {
+    if (line.size() < 2 || line[0] != ':' || line[1] != ' ') return false;
+
+    if (line.size() < 3 || line[2] < '0' || line[2] > '9') return false;
+    std::int64_t value = 0;
+    const auto [ptr, ec] = std::from_chars(line.data() + 2, line.data() + line.size(), value);
+    if (ec != std::errc{}) return false;
+    std::size_t pos = static_cast<std::size_t>(ptr - line.data());
+    if (pos == line.size() || line[pos] != ':') return false;
+
+    // Elapsed seconds are not used.
+    const std::size_t elapsed = ++pos;
+    while (pos < line.size() && line[pos] >= '0' && line[pos] <= '9') ++pos;
+    if (pos == elapsed || pos == line.size() || line[pos] != ';') return false;
+
+    time = value;
+    command = line.substr(pos + 1);
+    return true;
+}
+
+bool Command::isSkippableLine(std::string_view line) {
     if (line.empty()) return true;
-    if (!line.empty() && line[0] == '#') return true;
+    if (line[0] == '#') return true;
     return false;
 }
 
-std::vector<std::string> Command::tokenizeBoost(const std::string& line) {
-    boost::escaped_list_separator<char> sep('\\', ' ', '"');
-    boost::tokenizer<boost::escaped_list_separator<char>> tok(line, sep);
-    return std::vector<std::string>(tok.begin(), tok.end());
-}
+/// Split a line shell-style and classify tokens in the same pass:
+/// first token is the base, '-'-prefixed tokens are flags, everything else args.
+/// Plain tokens are views into the line; only quoted or escaped ones touch the arena.
+void Command::tokenize(std::string_view line, Arena& arena, Command& cmd) {
+    const std::size_t n = line.size();
+    std::size_t pos = 0;
+    bool first = true;
 
-std::string Command::extractBase(const std::vector<std::string>& tokens) {
-    if (tokens.empty()) return std::string();
-    return tokens.front();
-}
+    while (pos < n) {
+        while (pos < n && isBlank(line[pos])) ++pos;
+        if (pos == n) break;
 
-std::vector<std::string> Command::extractFlagsSorted(const std::vector<std::string>& tokens) {
-    std::vector<std::string> flags;
-    if (tokens.size() > 1) {
-        for (std::size_t i = 1; i < tokens.size(); ++i) {
-            const auto& t = tokens[i];
-            if (!t.empty() && t[0] == '-') {
-                flags.push_back(t);
-            }
+        // Fast path: token without quotes or escapes.
+        const std::size_t start = pos;
+        while (pos < n && !isTokenBreak(line[pos])) ++pos;
+
+        std::string_view token;
+        if (pos == n || isBlank(line[pos])) {
+            token = line.substr(start, pos - start);
+        } else {
+            pos = unquoteToken(line, start, arena, token);
+        }
+
+        if (first) {
+            cmd.base = token;
+            first = false;
+        } else if (!token.empty() && token[0] == '-') {
+            cmd.flags.push_back(token);
+        } else if (!token.empty()) {
+            cmd.args.push_back(token);
         }
     }
-    std::sort(flags.begin(), flags.end());
-    return flags;
+
+    std::sort(cmd.flags.begin(), cmd.flags.end());
 }
 
-std::vector<std::string> Command::extractArgs(const std::vector<std::string>& tokens) {
-    std::vector<std::string> args;
-    if (tokens.size() > 1) {
-        for (std::size_t i = 1; i < tokens.size(); ++i) {
-            const auto& t = tokens[i];
-            if (t.empty()) continue;
-            if (t[0] == '-') continue; 
-            args.push_back(t);
+/// Rewrite one token starting at pos into the arena, resolving '...' (literal), "..." (with \ escapes)
+/// and bare backslash escapes. An unterminated quote runs to the end of the line.
+/// Returns the position just past the token.
+std::size_t Command::unquoteToken(std::string_view line, std::size_t pos, Arena& arena, std::string_view& token) {
+    const std::size_t n = line.size();
+    // Unquoting never grows a token, so the rest of the line bounds it.
+    char* out = arena.reserve(n - pos);
+    std::size_t len = 0;
+
+    while (pos < n && !isBlank(line[pos])) {
+        const char c = line[pos];
+        if (c == '\'') {
+            ++pos;
+            while (pos < n && line[pos] != '\'') out[len++] = line[pos++];
+            if (pos < n) ++pos;
+        } else if (c == '"') {
+            ++pos;
+            while (pos < n && line[pos] != '"') {
+                if (line[pos] == '\\' && pos + 1 < n) ++pos;
+                out[len++] = line[pos++];
+            }
+            if (pos < n) ++pos;
+        } else if (c == '\\') {
+            ++pos;
+            if (pos < n) out[len++] = line[pos++];
+        } else {
+            out[len++] = line[pos++];
         }
     }
-    return args;
+
+    token = arena.commit(len);
+    return pos;
 }
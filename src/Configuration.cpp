@@ -1,12 +1,16 @@
 #include "Configuration.hpp"
 
+#include <stdexcept>
+#include <string>
+
 using namespace stars;
 
 Configuration::Configuration(std::string inputPath,
                              std::size_t width,
                              std::size_t height,
                              std::size_t maxConstellations)
-    : inputPath_(std::move(inputPath)),
+    : inputPath_(inputPath),
+      inputPaths_{std::move(inputPath)},
       width_(width),
       height_(height),
       maxConstellations_(maxConstellations) {}
@@ -15,3 +19,71 @@ std::string Configuration::getInputPath() const { return inputPath_; }
 std::size_t Configuration::getWidth() const { return width_; }
 std::size_t Configuration::getHeight() const { return height_; }
 std::size_t Configuration::getMaxConstellations() const { return maxConstellations_; }
+
+void Configuration::setInputPaths(std::vector<std::string> paths) {
+    if (paths.empty()) throw std::invalid_argument("No input history");
+    inputPath_ = paths.front();
+    inputPaths_ = std::move(paths);
+}
+const std::vector<std::string>& Configuration::getInputPaths() const { return inputPaths_; }
+
+void Configuration::setFollow(bool follow) { follow_ = follow; }
+bool Configuration::getFollow() const { return follow_; }
+
+void Configuration::setUseCache(bool useCache) { useCache_ = useCache; }
+bool Configuration::getUseCache() const { return useCache_; }
+
+void Configuration::setThreads(std::size_t threads) { threads_ = threads; }
+std::size_t Configuration::getThreads() const { return threads_; }
+
+void Configuration::setMemoryBudget(std::size_t bytes) { memoryBudget_ = bytes; }
+std::size_t Configuration::getMemoryBudget() const { return memoryBudget_; }
+
+void Configuration::setWindow(std::int64_t seconds) { window_ = seconds; }
+std::int64_t Configuration::getWindow() const { return window_; }
+
+void Configuration::setForceLayout(bool force) { forceLayout_ = force; }
+bool Configuration::getForceLayout() const { return forceLayout_; }
+
+void Configuration::setLayoutBudget(std::size_t iterations, std::chrono::milliseconds time) {
+    layoutIterations_ = iterations;
+    layoutTime_ = time;
+}
+std::size_t Configuration::getLayoutIterations() const { return layoutIterations_; }
+std::chrono::milliseconds Configuration::getLayoutTime() const { return layoutTime_; }
+
+void Configuration::setAnimate(bool animate) { animate_ = animate; }
+bool Configuration::getAnimate() const { return animate_; }
+
+void Configuration::setFramesPerSecond(std::size_t fps) {
+    if (fps == 0 || fps > kMaxFramesPerSecond) {
+        throw std::invalid_argument("Frame rate must be between 1 and " + std::to_string(kMaxFramesPerSecond));
+    }
+    framesPerSecond_ = fps;
+}
+std::size_t Configuration::getFramesPerSecond() const { return framesPerSecond_; }
+
+void Configuration::setColorDepth(int bits) {
+    if (bits != 0 && bits != 8 && bits != 24) throw std::invalid_argument("Colour depth must be 0, 8 or 24");
+    colorDepth_ = bits;
+}
+int Configuration::getColorDepth() const { return colorDepth_; }
+
+std::int64_t Configuration::parseDuration(const std::string& text) {
+    std::size_t digits = 0;
+    while (digits < text.size() && text[digits] >= '0' && text[digits] <= '9') ++digits;
+    if (digits == 0 || digits > 12 || text.size() > digits + 1) {
+        throw std::invalid_argument("Invalid duration: " + text);
+    }
+
+    const std::int64_t amount = std::stoll(text.substr(0, digits));
+    const char unit = digits < text.size() ? text[digits] : 's';
+    switch (unit) {
+        case 's': return amount;
+        case 'm': return amount * 60;
+        case 'h': return amount * 3600;
+        case 'd': return amount * 86400;
+        case 'w': return amount * 7 * 86400;
+        default: throw std::invalid_argument("Invalid duration unit in: " + text);
+    }
+}
@@ -1,181 +1,702 @@
 #include "Graph.hpp"
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <stdexcept>
+#include <thread>
 
 using namespace stars;
 
-void Graph::build(const std::vector<Command>& commands) {
+namespace {
+
+/// On-disk snapshot layout: a fixed header followed by 8-byte aligned POD sections, so a mapped
+/// file is read in place. Bump kSnapshotVersion on any layout change.
+constexpr char kSnapshotMagic[8] = {'S', 'T', 'A', 'R', 'S', 'N', 'A', 'P'};
+constexpr std::uint64_t kSnapshotVersion = 2;
+
+struct Section {
+    std::uint64_t offset;
+    std::uint64_t count;
+};
+
+struct SnapshotHeader {
+    char magic[8];
+    std::uint64_t version;
+    std::uint64_t headerSize;
+    std::uint64_t fileBytes;
+
+    // Source history fingerprint (path text lives in its own section).
+    std::uint64_t sourceSize;
+    std::int64_t sourceModifiedNs;
+    std::uint64_t sourceTailHash;
+    std::uint64_t sourceLineCount;
+    std::uint64_t sourceEndsWithNewline;
+
+    Section path;            // char
+    Section symbolOffsets;   // uint64, count = symbols + 1
+    Section symbolText;      // char
+    Section vertices;        // SnapshotVertex
+    Section flagWords;       // uint64
+    Section edges;           // SnapshotEdge
+    Section constellations;  // SnapshotConstellation
+    Section dictionaryFlags; // uint32
+    Section activity;        // Graph::Activity
+};
+
+struct SnapshotVertex {
+    std::uint32_t base;
+    std::uint32_t isBase;
+    std::uint64_t frequency;
+    std::uint64_t firstSeenIndex;
+    std::uint64_t flagCount;
+    std::uint64_t wordBegin;
+    std::uint64_t wordCount;
+    std::uint64_t activity;
+};
+
+struct SnapshotEdge {
+    std::uint64_t source;
+    std::uint64_t target;
+};
+
+struct SnapshotConstellation {
+    std::uint32_t base;
+    std::uint32_t reserved;
+    std::uint64_t vertex;
+    std::uint64_t flagBegin;
+    std::uint64_t flagCount;
+};
+
+/// Run work(t) for t in [0, threads), one thread each, and wait for all of them.
+template <typename Work>
+void runWorkers(std::size_t threads, Work&& work) {
+    std::vector<std::jthread> workers;
+    workers.reserve(threads - 1);
+    for (std::size_t t = 1; t < threads; ++t) workers.emplace_back([&work, t] { work(t); });
+    work(0);
+}
+
+/// Visit (shard, local slot) pairs in ascending command position across per-shard creation logs.
+/// A command belongs to one shard, so positions never tie between shards.
+template <typename Visit>
+void mergeByPosition(const std::vector<const std::vector<std::size_t>*>& logs, Visit&& visit) {
+    std::vector<std::size_t> cursor(logs.size(), 0);
+    for (;;) {
+        std::size_t best = logs.size();
+        for (std::size_t t = 0; t < logs.size(); ++t) {
+            if (cursor[t] < logs[t]->size() &&
+                (best == logs.size() || (*logs[t])[cursor[t]] < (*logs[best])[cursor[best]])) {
+                best = t;
+            }
+        }
+        if (best == logs.size()) return;
+        visit(best, cursor[best]++);
+    }
+}
+
+std::uint64_t alignUp(std::uint64_t n) { return (n + 7) & ~std::uint64_t{7}; }
+
+/// Map a whole file read-only; null when it is missing or empty.
+std::shared_ptr<const char> mapReadOnly(const std::string& path, std::size_t& size) {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return nullptr;
+    struct stat st {};
+    if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0) {
+        ::close(fd);
+        return nullptr;
+    }
+    size = static_cast<std::size_t>(st.st_size);
+    void* addr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) return nullptr;
+
+    return std::shared_ptr<const char>(static_cast<const char*>(addr), [size](const char* p) {
+        ::munmap(const_cast<char*>(p), size);
+    });
+}
+
+template <typename T>
+bool sectionFits(const Section& section, std::size_t fileSize) {
+    return section.offset % alignof(T) == 0 && section.offset <= fileSize &&
+           section.count <= (fileSize - section.offset) / sizeof(T);
+}
+
+template <typename T>
+const T* sectionData(const char* base, const Section& section) {
+    return reinterpret_cast<const T*>(base + section.offset);
+}
+
+}  // namespace
+
+void Graph::build(const std::vector<Command>& commands, std::size_t threads) {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = std::min(threads, std::max<std::size_t>(1, commands.size() / kMinCommandsPerShard));
+
     clearState();
+    if (threads > 1) {
+        buildSharded(commands, threads);
+    } else {
+        append(commands);
+    }
+}
+
+std::vector<Graph::Vertex> Graph::append(const std::vector<Command>& commands) {
+    std::vector<Vertex> changed;
+    foldCommands(commands, nullptr, 0, nullptr, changed);
+    relinkTouched(changed);
+
+    std::sort(changed.begin(), changed.end());
+    changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+    return changed;
+}
+
+void Graph::foldCommands(const std::vector<Command>& commands,
+                         const std::vector<std::size_t>* positions,
+                         std::size_t firstPosition,
+                         CreationLog* log,
+                         std::vector<Vertex>& changed) {
+    // Reused lookup key: only a first-seen variant copies it into the map.
+    VariantKey key;
+
+    // For each command, intern base and flags, then add or update its stars
+    auto fold = [&](std::size_t position) {
+        const Command& cmd = commands[position];
+        if (cmd.base.empty()) return;
+
+        key.base = intern(cmd.base);
+        auto it = constellations_.find(key.base);
+        Constellation& constellation =
+            (it != constellations_.end()) ? it->second : addBaseVertex(key.base, changed);
+
+        if (constellation.appendedFrom == kNotTouched) {
+            constellation.appendedFrom = constellation.variantsByTime.size();
+            touched_.push_back(key.base);
+        }
+
+        addOrUpdateVariant(cmd, key, constellation, changed);
+
+        if (log) {
+            log->vertices.resize(boost::num_vertices(graph_), firstPosition + position);
+            log->symbols.resize(symbols_.size(), firstPosition + position);
+        }
+    };
+    if (positions) {
+        for (std::size_t position : *positions) fold(position);
+    } else {
+        for (std::size_t position = 0; position < commands.size(); ++position) fold(position);
+    }
+}
 
-    // For each command, collect unique bases
-    auto bases = extractBases(commands);
+void Graph::relinkTouched(std::vector<Vertex>& changed) {
+    // Relink and re-sort only the touched bases
+    for (SymbolId base : touched_) {
+        Constellation& constellation = constellations_.at(base);
+        linkSpecializationChainForBase(constellation, changed);
+        indexVariants(constellation);
+        constellation.appendedFrom = kNotTouched;
+        constellation.needsRelink = false;
+    }
+    touched_.clear();
+}
+
+/// Constellations never share state, so each worker folds the bases hashed to it into a private
+/// Graph (aggregation and chain linking included). The serial build creates symbols and vertices in
+/// command order; replaying the shards' creation logs merged by command position reproduces exactly
+/// that numbering, after which stars, edges and per-base indexes are moved over with ids remapped.
+void Graph::buildSharded(const std::vector<Command>& commands, std::size_t threads) {
+    std::vector<std::uint32_t> shardOf(commands.size());
+    const std::size_t step = (commands.size() + threads - 1) / threads;
+    runWorkers(threads, [&](std::size_t t) {
+        const std::size_t end = std::min(commands.size(), (t + 1) * step);
+        for (std::size_t i = std::min(commands.size(), t * step); i < end; ++i) {
+            shardOf[i] = static_cast<std::uint32_t>(std::hash<std::string_view>{}(commands[i].base) % threads);
+        }
+    });
+
+    std::vector<Graph> shards(threads);
+    std::vector<CreationLog> logs(threads);
+    runWorkers(threads, [&](std::size_t t) {
+        std::vector<std::size_t> positions;
+        for (std::size_t i = 0; i < commands.size(); ++i) {
+            if (shardOf[i] == t) positions.push_back(i);
+        }
+        std::vector<Vertex> changed;
+        shards[t].foldCommands(commands, &positions, 0, &logs[t], changed);
+        shards[t].relinkTouched(changed);
+    });
+    mergeShards(shards, logs);
+}
 
-    addBaseVertices(bases);
+void Graph::mergeShards(std::vector<Graph>& shards, const std::vector<CreationLog>& logs) {
+    const std::size_t threads = shards.size();
 
-    // For each command, create a key and collect usage stats (usageByKey)
-    auto usageByKey = collectVariantUsage(commands);
+    // Symbols: interning in merged creation order yields the serial ids; a symbol created by several
+    // shards is first met at its globally earliest position.
+    std::vector<std::vector<SymbolId>> symbolMap(threads);
+    std::vector<const std::vector<std::size_t>*> symbolLogs;
+    for (std::size_t t = 0; t < threads; ++t) {
+        symbolMap[t].resize(shards[t].symbols_.size());
+        symbolLogs.push_back(&logs[t].symbols);
+    }
+    mergeByPosition(symbolLogs, [&](std::size_t t, std::size_t local) {
+        symbolMap[t][local] = intern(shards[t].symbols_[local]);
+    });
 
-    // For each usageByKey, add variant vertex
-    addVariantVertices(usageByKey);
+    // Vertices: same replay; dictionary bits are per base, so flag words carry over unchanged.
+    // Time buckets are concatenated in shard order, shifting each shard's slots.
+    std::vector<std::vector<Vertex>> vertexMap(threads);
+    std::vector<const std::vector<std::size_t>*> vertexLogs;
+    std::vector<std::uint32_t> activityOffset(threads);
+    for (std::size_t t = 0; t < threads; ++t) {
+        vertexMap[t].resize(boost::num_vertices(shards[t].graph_));
+        vertexLogs.push_back(&logs[t].vertices);
+        activityOffset[t] = static_cast<std::uint32_t>(activity_.size());
+        activity_.insert(activity_.end(), shards[t].activity_.begin(), shards[t].activity_.end());
+        latestTime_ = std::max(latestTime_, shards[t].latestTime_);
+    }
+    mergeByPosition(vertexLogs, [&](std::size_t t, std::size_t local) {
+        const Vertex v = boost::add_vertex(std::move(shards[t].graph_[local]), graph_);
+        StarVertex& star = graph_[v];
+        star.base = symbolMap[t][star.base];
+        if (star.activity != kNoActivity) star.activity += activityOffset[t];
+        vertexMap[t][local] = v;
+    });
 
-    // Connect bases to variants
-    addBaseToVariantEdges();
+    // Out-edge lists are per source, so copying each shard's lists in order keeps edge order.
+    std::size_t constellationCount = 0;
+    std::size_t variantCount = 0;
+    for (std::size_t t = 0; t < threads; ++t) {
+        const auto& map = vertexMap[t];
+        const BoostGraph& shardGraph = shards[t].graph_;
+        for (auto e : boost::make_iterator_range(boost::edges(shardGraph))) {
+            boost::add_edge(map[boost::source(e, shardGraph)], map[boost::target(e, shardGraph)], graph_);
+        }
+        constellationCount += shards[t].constellations_.size();
+        variantCount += shards[t].variantVertices_.size();
+    }
 
-    // Specialization chains per base
-    for (const auto& basePair : baseVertices_) {
-        linkSpecializationChainForBase(basePair.first);
+    constellations_.reserve(constellationCount);
+    variantVertices_.reserve(variantCount);
+    for (std::size_t t = 0; t < threads; ++t) {
+        const auto& symbolIds = symbolMap[t];
+        const auto& map = vertexMap[t];
+        for (auto& [base, shardConstellation] : shards[t].constellations_) {
+            Constellation& constellation = constellations_[symbolIds[base]] = std::move(shardConstellation);
+            constellation.vertex = map[constellation.vertex];
+            constellation.dictionary.bits.clear();
+            for (std::size_t bit = 0; bit < constellation.dictionary.flags.size(); ++bit) {
+                SymbolId& flag = constellation.dictionary.flags[bit];
+                flag = symbolIds[flag];
+                constellation.dictionary.bits.emplace(flag, bit);
+            }
+            for (auto& item : constellation.variantsByTime) item.vertex = map[item.vertex];
+            for (auto& vertex : constellation.variantsByFlagCount) vertex = map[vertex];
+        }
+        for (auto& [shardKey, vertex] : shards[t].variantVertices_) {
+            VariantKey key = shardKey;
+            key.base = symbolIds[key.base];
+            variantVertices_.emplace(std::move(key), map[vertex]);
+        }
     }
 }
 
+Graph::Builder::Builder(Graph& graph, std::size_t threads)
+    : graph_(graph), threads_(threads != 0 ? threads : std::max(1u, std::thread::hardware_concurrency())) {
+    // Shards stitch into an empty graph only; appends to a loaded one fold in place.
+    if (boost::num_vertices(graph_.graph_) > 0 || !graph_.symbols_.empty()) threads_ = 1;
+    changed_.resize(threads_);
+    if (threads_ == 1) return;
+
+    shards_.resize(threads_);
+    logs_.resize(threads_);
+    positions_.resize(threads_);
+    errors_.resize(threads_);
+    sync_ = std::make_unique<std::barrier<>>(static_cast<std::ptrdiff_t>(threads_));
+    workers_.reserve(threads_ - 1);
+    for (std::size_t t = 1; t < threads_; ++t) workers_.emplace_back([this, t] { work(t); });
+}
+
+Graph::Builder::~Builder() {
+    stopWorkers();
+}
+
+void Graph::Builder::add(const std::vector<Command>& commands) {
+    rethrowError();
+    if (threads_ == 1) {
+        graph_.foldCommands(commands, nullptr, 0, nullptr, changed_[0]);
+        changed_[0].clear();
+        return;
+    }
+
+    shardOf_.resize(commands.size());
+    for (std::size_t i = 0; i < commands.size(); ++i) {
+        shardOf_[i] = static_cast<std::uint32_t>(std::hash<std::string_view>{}(commands[i].base) % threads_);
+    }
+    batch_ = &commands;
+    sync_->arrive_and_wait();  // Workers take the batch...
+    foldShard(0);
+    sync_->arrive_and_wait();  // ...and are done with it, back at the first barrier.
+    batch_ = nullptr;
+    offset_ += commands.size();
+    rethrowError();
+}
+
+void Graph::Builder::finish() {
+    rethrowError();
+    if (threads_ == 1) {
+        graph_.relinkTouched(changed_[0]);
+        changed_[0].clear();
+        return;
+    }
+    stopWorkers();  // Each worker links its shard on the way out.
+    rethrowError();
+    shards_[0].relinkTouched(changed_[0]);
+    graph_.mergeShards(shards_, logs_);
+    shards_.clear();
+    logs_.clear();
+}
+
+/// Worker t folds its shard of every batch between the two barriers of add(), until stopped.
+void Graph::Builder::work(std::size_t t) {
+    for (;;) {
+        sync_->arrive_and_wait();
+        if (done_) break;
+        foldShard(t);
+        sync_->arrive_and_wait();
+    }
+    if (errors_[t]) return;
+    try {
+        shards_[t].relinkTouched(changed_[t]);
+    } catch (...) {
+        errors_[t] = std::current_exception();
+    }
+}
+
+/// Failures are kept for the calling thread rather than thrown, so every thread still reaches the
+/// barrier after the fold and the workers stay in step with add() and stopWorkers().
+void Graph::Builder::foldShard(std::size_t t) {
+    if (errors_[t]) return;
+    try {
+        auto& positions = positions_[t];
+        positions.clear();
+        for (std::size_t i = 0; i < shardOf_.size(); ++i) {
+            if (shardOf_[i] == t) positions.push_back(i);
+        }
+        shards_[t].foldCommands(*batch_, &positions, offset_, &logs_[t], changed_[t]);
+        changed_[t].clear();
+    } catch (...) {
+        errors_[t] = std::current_exception();
+    }
+}
+
+/// A failed fold leaves its shard partial, so the builder keeps failing from then on.
+void Graph::Builder::rethrowError() const {
+    for (const auto& error : errors_) {
+        if (error) std::rethrow_exception(error);
+    }
+}
+
+/// Workers wait at the first barrier of add() whenever the calling thread is outside it.
+void Graph::Builder::stopWorkers() {
+    if (workers_.empty()) return;
+    done_ = true;
+    sync_->arrive_and_wait();
+    workers_.clear();
+}
+
 void Graph::clearState() {
     graph_.clear();
-    baseVertices_.clear();
+    constellations_.clear();
     variantVertices_.clear();
+    symbolIds_.clear();
+    symbols_.clear();
+    symbolStorage_.clear();
+    snapshot_.reset();
+    activity_.clear();
+    latestTime_ = 0;
+    touched_.clear();
 }
 
-void Graph::addBaseVertices(const std::vector<std::string>& bases) {
-    for (const auto& base : bases) {
-        Vertex v = boost::add_vertex(graph_);
-        graph_[v].label = "<" + base + ">";
-        graph_[v].base = base;
-        graph_[v].flags.clear();
-        graph_[v].frequency = 0;
-        graph_[v].isBase = true;
-        graph_[v].firstSeenIndex = std::numeric_limits<std::size_t>::max();
+Graph::SymbolId Graph::intern(std::string_view text) {
+    auto it = symbolIds_.find(text);
+    if (it != symbolIds_.end()) return it->second;
 
-        baseVertices_[base] = v;
-    }
+    const auto id = static_cast<SymbolId>(symbols_.size());
+    std::string_view stored = symbolStorage_.emplace_back(text);
+    symbols_.push_back(stored);
+    symbolIds_.emplace(stored, id);
+    return id;
 }
 
-std::unordered_map<std::string, Graph::VariantUsage> Graph::collectVariantUsage(const std::vector<Command>& commands) const {
-    std::unordered_map<std::string, VariantUsage> byKey;
+void Graph::FlagSet::set(std::size_t bit) {
+    const std::size_t word = bit / 64;
+    if (word >= words.size()) words.resize(word + 1, 0);
+    words[word] |= std::uint64_t{1} << (bit % 64);
+}
 
-    for (const auto& cmd : commands) {
-        const std::string base = cmd.base;
-        if (base.empty()) continue;
+bool Graph::FlagSet::test(std::size_t bit) const {
+    const std::size_t word = bit / 64;
+    return word < words.size() && ((words[word] >> (bit % 64)) & 1u) != 0;
+}
 
-        // Build flag set (flags from Command are already sorted).
-        const auto& flagsVec = cmd.flags;
-        std::set<std::string> flagSet(flagsVec.begin(), flagsVec.end());
+std::size_t Graph::FlagSet::count() const {
+    std::size_t n = 0;
+    for (std::uint64_t w : words) n += static_cast<std::size_t>(std::popcount(w));
+    return n;
+}
 
-        const std::string key = makeKey(base, flagSet);
-        const std::size_t idx = cmd.index;
+bool Graph::FlagSet::isSubsetOf(const FlagSet& other) const {
+    // Normalized sets: a longer subset would need a non-zero word beyond other's end.
+    if (words.size() > other.words.size()) return false;
+    for (std::size_t i = 0; i < words.size(); ++i) {
+        if ((words[i] & ~other.words[i]) != 0) return false;
+    }
+    return true;
+}
 
-        auto it = byKey.find(key);
-        if (it == byKey.end()) {
-            VariantUsage usage;
-            usage.base = base;
-            usage.flags = std::move(flagSet);
-            usage.earliestIndex = idx;
-            usage.frequency = 1;
-            byKey.emplace(key, std::move(usage));
-        } else {
-            // Update earliest index and frequency.
-            if (idx < it->second.earliestIndex) {
-                it->second.earliestIndex = idx;
-            }
-            it->second.frequency += 1;
+template <typename Visit>
+void Graph::forEachBit(const std::uint64_t* words, std::size_t count, Visit&& visit) {
+    for (std::size_t w = 0; w < count; ++w) {
+        for (std::uint64_t bits = words[w]; bits != 0; bits &= bits - 1) {
+            visit(w * 64 + static_cast<std::size_t>(std::countr_zero(bits)));
         }
     }
+}
 
-    return byKey;
+std::size_t Graph::FlagDictionary::bitFor(SymbolId flag) {
+    auto [it, inserted] = bits.try_emplace(flag, flags.size());
+    if (inserted) flags.push_back(flag);
+    return it->second;
 }
 
-std::string Graph::makeKey(const std::string& base, const std::set<std::string>& flags) {
-    std::string key = base;
-    key.push_back('|');
-    bool first = true;
-    for (const auto& f : flags) {
-        if (!first) key.push_back(',');
-        key.append(f);
-        first = false;
+std::size_t Graph::VariantKeyHash::operator()(const VariantKey& key) const {
+    // 64-bit mix of the id tuple (splitmix-style finalizer per element).
+    std::uint64_t h = key.base * 0x9E3779B97F4A7C15ull;
+    for (std::uint64_t w : key.flags.words) {
+        h ^= w + 0x9E3779B97F4A7C15ull + (h << 6) + (h >> 2);
     }
-    return key;
+    h ^= h >> 31;
+    h *= 0xBF58476D1CE4E5B9ull;
+    h ^= h >> 27;
+    return static_cast<std::size_t>(h);
 }
 
-std::string Graph::makeLabel(const std::string& base, const std::set<std::string>& flags) {
-    std::string label;
-    label.push_back('<');
-    label.append(base);
-    if (!flags.empty()) {
-        label.push_back(' ');
-        bool first = true;
-        for (const auto& f : flags) {
-            if (!first) label.push_back(' ');
-            label.append(f);
-            first = false;
+Graph::Constellation& Graph::addBaseVertex(SymbolId base, std::vector<Vertex>& changed) {
+    Vertex v = boost::add_vertex(graph_);
+    graph_[v].base = base;
+    graph_[v].flags = FlagSet{};
+    graph_[v].flagCount = 0;
+    graph_[v].frequency = 0;
+    graph_[v].isBase = true;
+    graph_[v].firstSeenIndex = std::numeric_limits<std::size_t>::max();
+    changed.push_back(v);
+
+    Constellation& constellation = constellations_[base];
+    constellation.vertex = v;
+    return constellation;
+}
+
+void Graph::addOrUpdateVariant(const Command& cmd, VariantKey& key, Constellation& constellation,
+                               std::vector<Vertex>& changed) {
+    key.flags.words.clear();
+    for (std::string_view flag : cmd.flags) {
+        key.flags.set(constellation.dictionary.bitFor(intern(flag)));
+    }
+
+    const std::size_t idx = cmd.index;
+
+    auto it = variantVertices_.find(key);
+    if (it != variantVertices_.end()) {
+        // Update earliest index and frequency.
+        StarVertex& star = graph_[it->second];
+        if (idx < star.firstSeenIndex) {
+            star.firstSeenIndex = idx;
+            constellation.needsRelink = true;
         }
+        star.frequency += 1;
+        recordUse(it->second, cmd.timestamp);
+        changed.push_back(it->second);
+        return;
     }
-    label.push_back('>');
-    return label;
+
+    Vertex v = boost::add_vertex(graph_);
+    graph_[v].base = key.base;
+    graph_[v].flags = key.flags;
+    graph_[v].flagCount = key.flags.count();
+    graph_[v].isBase = false;
+    graph_[v].firstSeenIndex = idx;
+    graph_[v].frequency = 1;
+    recordUse(v, cmd.timestamp);
+    changed.push_back(v);
+
+    // Connect base to variant
+    boost::add_edge(constellation.vertex, v, graph_);
+
+    // A variant older than an existing one reorders the chain: relink the whole base.
+    if (!constellation.variantsByTime.empty() && idx < constellation.latestFirstSeen) {
+        constellation.needsRelink = true;
+    }
+    constellation.latestFirstSeen = std::max(constellation.latestFirstSeen, idx);
+    constellation.variantsByTime.push_back(VariantItem{v, idx, graph_[v].flagCount});
+    variantVertices_.emplace(key, v);
+}
+
+void Graph::recordUse(Vertex v, std::int64_t time) {
+    if (time == 0) return;
+    StarVertex& star = graph_[v];
+    if (star.activity == kNoActivity) {
+        star.activity = static_cast<std::uint32_t>(activity_.size());
+        activity_.emplace_back();
+    }
+    activity_[star.activity].add(time);
+    latestTime_ = std::max(latestTime_, time);
+}
+
+namespace {
+
+std::int64_t floorDiv(std::int64_t a, std::int64_t b) {
+    return a / b - ((a % b != 0) && ((a < 0) != (b < 0)));
 }
 
-bool Graph::isStrictSuperset(const std::set<std::string>& a, const std::set<std::string>& b) {
-    if (a.size() >= b.size()) return false;
-    return std::includes(b.begin(), b.end(), a.begin(), a.end());
+std::size_t ringSlot(std::int64_t bucket, std::size_t size) {
+    const auto n = static_cast<std::int64_t>(size);
+    return static_cast<std::size_t>(((bucket % n) + n) % n);
 }
 
-std::vector<std::string> Graph::extractBases(const std::vector<Command>& commands) {
-    std::set<std::string> uniques;
-    for (const auto& cmd : commands) {
-        const std::string base = cmd.base;
-        if (!base.empty()) uniques.insert(base);
+/// Count one use in bucket, moving the ring forward (and zeroing the buckets it passes) first.
+template <std::size_t N>
+void bumpRing(std::array<std::uint32_t, N>& ring, std::int64_t& newest, std::int64_t bucket) {
+    if (bucket > newest) {
+        const std::int64_t gap = std::min<std::int64_t>(bucket - newest, static_cast<std::int64_t>(N));
+        for (std::int64_t i = 1; i <= gap; ++i) ring[ringSlot(newest + i, N)] = 0;
+        newest = bucket;
     }
-    return std::vector<std::string>(uniques.begin(), uniques.end());
+    if (bucket > newest - static_cast<std::int64_t>(N)) ++ring[ringSlot(bucket, N)];
+}
+
+/// Sum the buckets from since to newest, or nullopt when since is older than the ring.
+template <std::size_t N>
+std::optional<std::uint64_t> sumRing(const std::array<std::uint32_t, N>& ring, std::int64_t newest, std::int64_t since) {
+    if (since <= newest - static_cast<std::int64_t>(N)) return std::nullopt;
+    std::uint64_t total = 0;
+    for (std::int64_t bucket = since; bucket <= newest; ++bucket) total += ring[ringSlot(bucket, N)];
+    return total;
 }
 
-void Graph::addVariantVertices(const std::unordered_map<std::string, VariantUsage>& usageByKey) {
-    for (const auto& kv : usageByKey) {
-        const std::string& key = kv.first;
-        const VariantUsage& usage = kv.second;
+}  // namespace
 
-        Vertex v = boost::add_vertex(graph_);
-        graph_[v].base = usage.base;
-        graph_[v].flags = usage.flags;
-        graph_[v].label = makeLabel(usage.base, usage.flags);
-        graph_[v].isBase = false;
-        graph_[v].firstSeenIndex = usage.earliestIndex;
-        graph_[v].frequency = usage.frequency;
+void Graph::Activity::add(std::int64_t time) {
+    const std::int64_t hour = floorDiv(time, 3600);
+    const std::int64_t day = floorDiv(time, 86400);
+    if (lastSeen == 0) {
+        newestHour = hour;
+        newestDay = day;
+        lastSeen = time;
+    }
+    bumpRing(hours, newestHour, hour);
+    bumpRing(days, newestDay, day);
 
-        variantVertices_[key] = v;
+    // Keep heat anchored at the newest use; older uses arrive pre-decayed.
+    if (time >= lastSeen) {
+        heat = heat * std::exp2(-static_cast<double>(time - lastSeen) / kHalfLifeSeconds) + 1.0;
+        lastSeen = time;
+    } else {
+        heat += std::exp2(-static_cast<double>(lastSeen - time) / kHalfLifeSeconds);
     }
 }
 
-void Graph::addBaseToVariantEdges() {
-    for (const auto& kv : variantVertices_) {
-        const std::string& key = kv.first;
-        Vertex variant = kv.second;
+std::uint64_t Graph::Activity::countSince(std::int64_t since) const {
+    if (lastSeen == 0 || since > lastSeen) return 0;
+    if (auto recent = sumRing(hours, newestHour, floorDiv(since, 3600))) return *recent;
+    if (auto recent = sumRing(days, newestDay, floorDiv(since, 86400))) return *recent;
+    return *sumRing(days, newestDay, newestDay - static_cast<std::int64_t>(kDays) + 1);
+}
 
-        const std::size_t pipePos = key.find('|');
-        const std::string base = (pipePos == std::string::npos) ? key : key.substr(0, pipePos);
+double Graph::Activity::heatAt(std::int64_t now) const {
+    if (lastSeen == 0) return 0.0;
+    if (now <= lastSeen) return heat;
+    return heat * std::exp2(-static_cast<double>(now - lastSeen) / kHalfLifeSeconds);
+}
 
-        auto itBase = baseVertices_.find(base);
-        if (itBase != baseVertices_.end()) {
-            boost::add_edge(itBase->second, variant, graph_);
-        }
+std::size_t Graph::getUsesSince(Vertex v, std::int64_t since) const {
+    const StarVertex& star = graph_[v];
+    if (star.isBase) {
+        std::size_t total = 0;
+        for (Vertex variant : constellations_.at(star.base).variantsByFlagCount) total += getUsesSince(variant, since);
+        return total;
     }
+    if (since <= 0) return star.frequency;
+    if (star.activity == kNoActivity) return 0;
+    return static_cast<std::size_t>(activity_[star.activity].countSince(since));
 }
 
-std::vector<Graph::VariantItem> Graph::getVariantItemsForBase(const std::string& base) const {
-    std::vector<VariantItem> items;
-    items.reserve(16);
+double Graph::getHeat(Vertex v, std::int64_t now) const {
+    const StarVertex& star = graph_[v];
+    if (star.isBase) {
+        double total = 0.0;
+        for (Vertex variant : constellations_.at(star.base).variantsByFlagCount) total += getHeat(variant, now);
+        return total;
+    }
+    if (star.activity == kNoActivity) return 0.0;
+    return activity_[star.activity].heatAt(now);
+}
 
-    for (const auto& kv : variantVertices_) {
-        const std::size_t pipePos = kv.first.find('|');
-        const std::string keyBase =
-            (pipePos == std::string::npos) ? kv.first : kv.first.substr(0, pipePos);
+std::int64_t Graph::getLatestTime() const {
+    return latestTime_;
+}
 
-        if (keyBase == base) {
-            Vertex v = kv.second;
-            VariantItem item;
-            item.vertex = v;
-            item.firstSeenIndex = graph_[v].firstSeenIndex;
-            item.flagCount = graph_[v].flags.size();
-            items.push_back(item);
-        }
+std::string_view Graph::getSymbol(SymbolId id) const {
+    return symbols_.at(id);
+}
+
+std::string Graph::getLabel(Vertex v) const {
+    const StarVertex& star = graph_[v];
+
+    // Flags are stored as dictionary bits; labels list them by name.
+    std::vector<std::string_view> names;
+    names.reserve(star.flagCount);
+    if (star.flagCount > 0) {
+        const FlagDictionary& dictionary = constellations_.at(star.base).dictionary;
+        forEachBit(star.flags.words.data(), star.flags.words.size(),
+                   [&](std::size_t bit) { names.push_back(symbols_[dictionary.flags[bit]]); });
     }
+    std::sort(names.begin(), names.end());
 
-    return items;
+    std::string label;
+    label.push_back('<');
+    label.append(symbols_[star.base]);
+    for (std::string_view f : names) {
+        label.push_back(' ');
+        label.append(f);
+    }
+    label.push_back('>');
+    return label;
+}
+
+/// (a & ~b) == 0 over equally wide packed rows; with a smaller popcount this is a strict superset test.
+bool Graph::isSubset(const std::uint64_t* a, const std::uint64_t* b, std::size_t words) {
+    std::uint64_t stray = 0;
+    for (std::size_t w = 0; w < words; ++w) stray |= a[w] & ~b[w];
+    return stray == 0;
+}
+
+void Graph::indexVariants(Constellation& constellation) {
+    std::vector<VariantItem> byFlags(constellation.variantsByTime);
+    std::sort(byFlags.begin(), byFlags.end(), fewerFlagsThenEarlier);
+    constellation.variantsByFlagCount.clear();
+    constellation.variantsByFlagCount.reserve(byFlags.size());
+    for (const auto& item : byFlags) constellation.variantsByFlagCount.push_back(item.vertex);
 }
 
 bool Graph::earlierByTime(const VariantItem& a, const VariantItem& b) {
@@ -187,47 +708,414 @@ bool Graph::fewerFlagsThenEarlier(const VariantItem& a, const VariantItem& b) {
     return a.firstSeenIndex < b.firstSeenIndex;
 }
 
-void Graph::linkSpecializationChainForBase(const std::string& base) {
-    // Gather and sort by time ascending.
-    std::vector<VariantItem> items = getVariantItemsForBase(base);
-    std::sort(items.begin(), items.end(), earlierByTime);
+/// Chain the variants added by this append. A variant that already has a successor keeps it: later
+/// variants can never be earlier supersets. Open variants (no successor yet) and the new ones are
+/// queried together in time order; no open variant is a superset of an earlier open one, so their
+/// successors can only be new variants. When firstSeenIndex order changed, the base is relinked whole.
+void Graph::linkSpecializationChainForBase(Constellation& constellation, std::vector<Vertex>& changed) {
+    auto& byTime = constellation.variantsByTime;
+
+    std::vector<const VariantItem*> open;
+    if (constellation.needsRelink) {
+        for (auto& item : byTime) {
+            boost::clear_out_edges(item.vertex, graph_);
+            item.firstSeenIndex = graph_[item.vertex].firstSeenIndex;
+            changed.push_back(item.vertex);
+        }
+        std::sort(byTime.begin(), byTime.end(), earlierByTime);
+        for (const auto& item : byTime) open.push_back(&item);
+    } else {
+        for (std::size_t i = 0; i < byTime.size(); ++i) {
+            if (i >= constellation.appendedFrom || boost::out_degree(byTime[i].vertex, graph_) == 0) {
+                open.push_back(&byTime[i]);
+            }
+        }
+    }
+
+    // Pack flag words row-major in time order so lattice queries stream through one array.
+    std::size_t stride = 1;
+    for (const auto* item : open) stride = std::max(stride, graph_[item->vertex].flags.words.size());
+    std::vector<std::uint64_t> rows(open.size() * stride, 0);
+    std::vector<std::size_t> counts(open.size());
+    for (std::size_t i = 0; i < open.size(); ++i) {
+        const auto& words = graph_[open[i]->vertex].flags.words;
+        std::copy(words.begin(), words.end(), rows.begin() + static_cast<std::ptrdiff_t>(i * stride));
+        counts[i] = open[i]->flagCount;
+    }
 
     // Link A -> B when B is the next later strict superset of A's flags.
-    for (std::size_t i = 0; i < items.size(); ++i) {
-        const auto& flagsA = graph_[items[i].vertex].flags;
+    const auto successors = findChainSuccessors(rows, counts, stride, constellation.dictionary.flags.size());
+    for (std::size_t i = 0; i < open.size(); ++i) {
+        if (successors[i] != kNoSuccessor) {
+            boost::add_edge(open[i]->vertex, open[successors[i]]->vertex, graph_);
+            changed.push_back(open[i]->vertex);
+        }
+    }
+}
+
+/// For each variant (rows in time order), the earliest later variant whose flags strictly contain it.
+/// Inverted posting lists per flag bit, each in time order, answer the query: any superset of A must
+/// appear in the list of A's rarest flag, so only that list past A is walked and bit-tested.
+/// Flagless variants chain to the next variant with any flag.
+std::vector<std::size_t> Graph::findChainSuccessors(const std::vector<std::uint64_t>& rows,
+                                                    const std::vector<std::size_t>& counts,
+                                                    std::size_t stride,
+                                                    std::size_t bitCount) {
+    const std::size_t n = counts.size();
+    std::vector<std::size_t> successors(n, kNoSuccessor);
+    if (n < 2) return successors;
 
-        for (std::size_t j = i + 1; j < items.size(); ++j) {
-            const auto& flagsB = graph_[items[j].vertex].flags;
+    // Postings in CSR form: offsets[b]..offsets[b+1] lists the rows holding bit b, ascending.
+    std::vector<std::size_t> offsets(bitCount + 1, 0);
+    for (std::size_t i = 0; i < n; ++i) {
+        forEachBit(&rows[i * stride], stride, [&](std::size_t bit) { ++offsets[bit + 1]; });
+    }
+    for (std::size_t b = 0; b < bitCount; ++b) offsets[b + 1] += offsets[b];
+    std::vector<std::uint32_t> postings(offsets[bitCount]);
+    {
+        std::vector<std::size_t> fill(offsets.begin(), offsets.end() - 1);
+        for (std::size_t i = 0; i < n; ++i) {
+            forEachBit(&rows[i * stride], stride,
+                       [&](std::size_t bit) { postings[fill[bit]++] = static_cast<std::uint32_t>(i); });
+        }
+    }
 
-            if (isStrictSuperset(flagsA, flagsB)) {
-                boost::add_edge(items[i].vertex, items[j].vertex, graph_);
-                break;  // Only chain to the next chronological superset.
+    std::size_t nextWithFlags = kNoSuccessor;
+    for (std::size_t i = n; i-- > 0;) {
+        if (counts[i] == 0) {
+            successors[i] = nextWithFlags;
+        } else {
+            const std::uint64_t* a = &rows[i * stride];
+
+            std::size_t rarest = 0;
+            std::size_t rarestSize = std::numeric_limits<std::size_t>::max();
+            forEachBit(a, stride, [&](std::size_t bit) {
+                const std::size_t size = offsets[bit + 1] - offsets[bit];
+                if (size < rarestSize) {
+                    rarestSize = size;
+                    rarest = bit;
+                }
+            });
+
+            const auto first = postings.begin() + static_cast<std::ptrdiff_t>(offsets[rarest]);
+            const auto last = postings.begin() + static_cast<std::ptrdiff_t>(offsets[rarest + 1]);
+            for (auto it = std::upper_bound(first, last, static_cast<std::uint32_t>(i)); it != last; ++it) {
+                const std::size_t j = *it;
+                if (counts[i] < counts[j] && isSubset(a, &rows[j * stride], stride)) {
+                    successors[i] = j;
+                    break;  // Only chain to the next chronological superset.
+                }
             }
+            nextWithFlags = i;
+        }
+    }
+    return successors;
+}
+
+void Graph::saveSnapshot(const std::string& path, const History::Fingerprint& source) const {
+    // Flatten into section buffers first, then lay them out back to back.
+    std::vector<std::uint64_t> symbolOffsets{0};
+    std::string symbolText;
+    for (std::string_view symbol : symbols_) {
+        symbolText.append(symbol);
+        symbolOffsets.push_back(symbolText.size());
+    }
+
+    std::vector<SnapshotVertex> vertices;
+    std::vector<std::uint64_t> flagWords;
+    vertices.reserve(boost::num_vertices(graph_));
+    for (auto v : boost::make_iterator_range(boost::vertices(graph_))) {
+        const StarVertex& star = graph_[v];
+        vertices.push_back(SnapshotVertex{star.base, star.isBase ? 1u : 0u, star.frequency, star.firstSeenIndex,
+                                          star.flagCount, flagWords.size(), star.flags.words.size(), star.activity});
+        flagWords.insert(flagWords.end(), star.flags.words.begin(), star.flags.words.end());
+    }
+
+    std::vector<SnapshotEdge> edges;
+    edges.reserve(boost::num_edges(graph_));
+    for (auto e : boost::make_iterator_range(boost::edges(graph_))) {
+        edges.push_back(SnapshotEdge{boost::source(e, graph_), boost::target(e, graph_)});
+    }
+
+    std::vector<SnapshotConstellation> constellations;
+    std::vector<std::uint32_t> dictionaryFlags;
+    constellations.reserve(constellations_.size());
+    for (const auto& [base, constellation] : constellations_) {
+        const auto& flags = constellation.dictionary.flags;
+        constellations.push_back(SnapshotConstellation{base, 0, constellation.vertex, dictionaryFlags.size(), flags.size()});
+        dictionaryFlags.insert(dictionaryFlags.end(), flags.begin(), flags.end());
+    }
+
+    SnapshotHeader header{};
+    std::memcpy(header.magic, kSnapshotMagic, sizeof(header.magic));
+    header.version = kSnapshotVersion;
+    header.headerSize = sizeof(SnapshotHeader);
+    header.sourceSize = source.size;
+    header.sourceModifiedNs = source.modifiedNs;
+    header.sourceTailHash = source.tailHash;
+    header.sourceLineCount = source.lineCount;
+    header.sourceEndsWithNewline = source.endsWithNewline ? 1 : 0;
+
+    std::uint64_t cursor = alignUp(sizeof(SnapshotHeader));
+    auto place = [&cursor](Section& section, std::size_t count, std::size_t elementSize) {
+        section.offset = cursor;
+        section.count = count;
+        cursor = alignUp(cursor + count * elementSize);
+    };
+    place(header.path, source.path.size(), 1);
+    place(header.symbolOffsets, symbolOffsets.size(), sizeof(std::uint64_t));
+    place(header.symbolText, symbolText.size(), 1);
+    place(header.vertices, vertices.size(), sizeof(SnapshotVertex));
+    place(header.flagWords, flagWords.size(), sizeof(std::uint64_t));
+    place(header.edges, edges.size(), sizeof(SnapshotEdge));
+    place(header.constellations, constellations.size(), sizeof(SnapshotConstellation));
+    place(header.dictionaryFlags, dictionaryFlags.size(), sizeof(std::uint32_t));
+    place(header.activity, activity_.size(), sizeof(Activity));
+    header.fileBytes = cursor;
+
+    std::string image(cursor, '\0');
+    auto put = [&image](const Section& section, const void* data, std::size_t bytes) {
+        if (bytes > 0) std::memcpy(image.data() + section.offset, data, bytes);
+    };
+    put(Section{0, 1}, &header, sizeof(header));
+    put(header.path, source.path.data(), source.path.size());
+    put(header.symbolOffsets, symbolOffsets.data(), symbolOffsets.size() * sizeof(std::uint64_t));
+    put(header.symbolText, symbolText.data(), symbolText.size());
+    put(header.vertices, vertices.data(), vertices.size() * sizeof(SnapshotVertex));
+    put(header.flagWords, flagWords.data(), flagWords.size() * sizeof(std::uint64_t));
+    put(header.edges, edges.data(), edges.size() * sizeof(SnapshotEdge));
+    put(header.constellations, constellations.data(), constellations.size() * sizeof(SnapshotConstellation));
+    put(header.dictionaryFlags, dictionaryFlags.data(), dictionaryFlags.size() * sizeof(std::uint32_t));
+    put(header.activity, activity_.data(), activity_.size() * sizeof(Activity));
+
+    // Write beside the target and rename, so readers never see a torn snapshot.
+    const std::string temporary = path + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        out.write(image.data(), static_cast<std::streamsize>(image.size()));
+        if (!out) {
+            throw std::runtime_error("Cannot write snapshot: " + temporary);
         }
     }
+    std::filesystem::rename(temporary, path);
+}
+
+std::optional<History::Fingerprint> Graph::loadSnapshot(const std::string& path) {
+    std::size_t size = 0;
+    auto mapping = mapReadOnly(path, size);
+    if (!mapping || size < sizeof(SnapshotHeader)) return std::nullopt;
+
+    const char* base = mapping.get();
+    SnapshotHeader header;
+    std::memcpy(&header, base, sizeof(header));
+    if (std::memcmp(header.magic, kSnapshotMagic, sizeof(header.magic)) != 0 ||
+        header.version != kSnapshotVersion || header.headerSize != sizeof(SnapshotHeader) ||
+        header.fileBytes != size) {
+        return std::nullopt;
+    }
+    if (!sectionFits<char>(header.path, size) || !sectionFits<std::uint64_t>(header.symbolOffsets, size) ||
+        !sectionFits<char>(header.symbolText, size) || !sectionFits<SnapshotVertex>(header.vertices, size) ||
+        !sectionFits<std::uint64_t>(header.flagWords, size) || !sectionFits<SnapshotEdge>(header.edges, size) ||
+        !sectionFits<SnapshotConstellation>(header.constellations, size) ||
+        !sectionFits<std::uint32_t>(header.dictionaryFlags, size) || !sectionFits<Activity>(header.activity, size) ||
+        header.symbolOffsets.count == 0) {
+        return std::nullopt;
+    }
+
+    const auto* offsets = sectionData<std::uint64_t>(base, header.symbolOffsets);
+    const auto* text = sectionData<char>(base, header.symbolText);
+    const auto* vertices = sectionData<SnapshotVertex>(base, header.vertices);
+    const auto* words = sectionData<std::uint64_t>(base, header.flagWords);
+    const auto* edges = sectionData<SnapshotEdge>(base, header.edges);
+    const auto* constellations = sectionData<SnapshotConstellation>(base, header.constellations);
+    const auto* dictionaryFlags = sectionData<std::uint32_t>(base, header.dictionaryFlags);
+    const auto* activity = sectionData<Activity>(base, header.activity);
+
+    const std::size_t symbolCount = header.symbolOffsets.count - 1;
+    const std::size_t vertexCount = header.vertices.count;
+
+    // Validate every cross-reference before touching graph state.
+    for (std::size_t i = 0; i < symbolCount; ++i) {
+        if (offsets[i] > offsets[i + 1] || offsets[i + 1] > header.symbolText.count) return std::nullopt;
+    }
+    for (std::size_t i = 0; i < vertexCount; ++i) {
+        const auto& v = vertices[i];
+        if (v.base >= symbolCount || v.wordBegin > header.flagWords.count ||
+            v.wordCount > header.flagWords.count - v.wordBegin ||
+            (v.activity != kNoActivity && v.activity >= header.activity.count)) {
+            return std::nullopt;
+        }
+    }
+    for (std::size_t i = 0; i < header.edges.count; ++i) {
+        if (edges[i].source >= vertexCount || edges[i].target >= vertexCount) return std::nullopt;
+    }
+    for (std::size_t i = 0; i < header.constellations.count; ++i) {
+        const auto& c = constellations[i];
+        if (c.base >= symbolCount || c.vertex >= vertexCount || c.flagBegin > header.dictionaryFlags.count ||
+            c.flagCount > header.dictionaryFlags.count - c.flagBegin) {
+            return std::nullopt;
+        }
+        for (std::size_t f = 0; f < c.flagCount; ++f) {
+            if (dictionaryFlags[c.flagBegin + f] >= symbolCount) return std::nullopt;
+        }
+    }
+
+    clearState();
+
+    // Symbols: views straight into the mapping.
+    symbols_.reserve(symbolCount);
+    symbolIds_.reserve(symbolCount);
+    for (std::size_t i = 0; i < symbolCount; ++i) {
+        std::string_view symbol(text + offsets[i], offsets[i + 1] - offsets[i]);
+        symbols_.push_back(symbol);
+        symbolIds_.emplace(symbol, static_cast<SymbolId>(i));
+    }
+
+    for (const auto& c : std::span(constellations, header.constellations.count)) {
+        Constellation& constellation = constellations_[c.base];
+        constellation.vertex = c.vertex;
+        for (std::size_t f = 0; f < c.flagCount; ++f) {
+            constellation.dictionary.bitFor(dictionaryFlags[c.flagBegin + f]);
+        }
+    }
+
+    for (std::size_t i = 0; i < vertexCount; ++i) {
+        const auto& record = vertices[i];
+        Vertex v = boost::add_vertex(graph_);
+        StarVertex& star = graph_[v];
+        star.base = record.base;
+        star.flags.words.assign(words + record.wordBegin, words + record.wordBegin + record.wordCount);
+        star.flagCount = record.flagCount;
+        star.frequency = record.frequency;
+        star.isBase = record.isBase != 0;
+        star.firstSeenIndex = record.firstSeenIndex;
+        star.activity = static_cast<std::uint32_t>(record.activity);
+
+        if (star.isBase) continue;
+        auto it = constellations_.find(star.base);
+        if (it == constellations_.end()) {
+            clearState();
+            return std::nullopt;
+        }
+        Constellation& constellation = it->second;
+        constellation.variantsByTime.push_back(VariantItem{v, star.firstSeenIndex, star.flagCount});
+        constellation.latestFirstSeen = std::max(constellation.latestFirstSeen, star.firstSeenIndex);
+        variantVertices_.emplace(VariantKey{star.base, star.flags}, v);
+    }
+
+    for (const auto& e : std::span(edges, header.edges.count)) {
+        boost::add_edge(e.source, e.target, graph_);
+    }
+
+    activity_.assign(activity, activity + header.activity.count);
+    for (const Activity& buckets : activity_) latestTime_ = std::max(latestTime_, buckets.lastSeen);
+
+    for (auto& [symbol, constellation] : constellations_) {
+        std::sort(constellation.variantsByTime.begin(), constellation.variantsByTime.end(), earlierByTime);
+        indexVariants(constellation);
+    }
+
+    snapshot_ = std::move(mapping);
+
+    History::Fingerprint source;
+    source.path.assign(sectionData<char>(base, header.path), header.path.count);
+    source.size = header.sourceSize;
+    source.modifiedNs = header.sourceModifiedNs;
+    source.tailHash = header.sourceTailHash;
+    source.lineCount = header.sourceLineCount;
+    source.endsWithNewline = header.sourceEndsWithNewline != 0;
+    return source;
 }
 
 const Graph::BoostGraph& Graph::getBoostGraph() const {
     return graph_;
 }
 
-std::vector<Graph::Vertex> Graph::getBaseVertices() const {
-    std::vector<Vertex> out;
-    out.reserve(baseVertices_.size());
-    for (const auto& kv : baseVertices_) {
-        out.push_back(kv.second);
+Graph::Frozen Graph::freeze(std::int64_t since) const {
+    Frozen out;
+    const std::size_t n = boost::num_vertices(graph_);
+
+    out.flagCounts_.reserve(n);
+    out.frequencies_.reserve(n);
+    out.firstSeen_.reserve(n);
+    out.isBase_.reserve(n);
+    out.edgeOffsets_.reserve(n + 1);
+    out.variantOffsets_.reserve(n + 1);
+    out.labelOffsets_.reserve(n + 1);
+    out.edgeTargets_.reserve(boost::num_edges(graph_));
+    out.variants_.reserve(variantVertices_.size());
+    out.bases_.reserve(constellations_.size());
+
+    for (Vertex v = 0; v < n; ++v) {
+        const StarVertex& star = graph_[v];
+        out.flagCounts_.push_back(static_cast<std::uint32_t>(star.flagCount));
+        std::size_t frequency = star.isBase ? 0 : getUsesSince(v, since);
+        out.firstSeen_.push_back(star.firstSeenIndex);
+        out.isBase_.push_back(star.isBase ? 1 : 0);
+
+        out.edgeOffsets_.push_back(static_cast<std::uint32_t>(out.edgeTargets_.size()));
+        for (auto e : boost::make_iterator_range(boost::out_edges(v, graph_))) {
+            out.edgeTargets_.push_back(static_cast<std::uint32_t>(boost::target(e, graph_)));
+        }
+
+        out.variantOffsets_.push_back(static_cast<std::uint32_t>(out.variants_.size()));
+        if (star.isBase) {
+            for (Vertex variant : constellations_.at(star.base).variantsByFlagCount) {
+                const std::size_t uses = getUsesSince(variant, since);
+                if (uses == 0) continue;  // Only possible inside a window.
+                out.variants_.push_back(static_cast<std::uint32_t>(variant));
+                frequency += uses;
+            }
+            if (frequency > 0) out.bases_.push_back(static_cast<std::uint32_t>(v));
+        }
+        // Saturate rather than wrap past 4G uses.
+        out.frequencies_.push_back(static_cast<std::uint32_t>(std::min<std::size_t>(frequency, UINT32_MAX)));
+
+        out.labelOffsets_.push_back(static_cast<std::uint32_t>(out.labels_.size()));
+        out.labels_.append(getLabel(v));
     }
+    out.edgeOffsets_.push_back(static_cast<std::uint32_t>(out.edgeTargets_.size()));
+    out.variantOffsets_.push_back(static_cast<std::uint32_t>(out.variants_.size()));
+    out.labelOffsets_.push_back(static_cast<std::uint32_t>(out.labels_.size()));
     return out;
 }
 
-std::vector<Graph::Vertex> Graph::getVariantsForBase(Vertex baseVertex) const {
-    const std::string baseName = graph_[baseVertex].base;
+std::size_t Graph::Frozen::getVertexCount() const { return isBase_.size(); }
+std::size_t Graph::Frozen::getEdgeCount() const { return edgeTargets_.size(); }
+
+bool Graph::Frozen::isBase(Vertex v) const { return isBase_[v] != 0; }
+std::size_t Graph::Frozen::getFlagCount(Vertex v) const { return flagCounts_[v]; }
+std::size_t Graph::Frozen::getFrequency(Vertex v) const { return frequencies_[v]; }
+std::size_t Graph::Frozen::getFirstSeenIndex(Vertex v) const { return firstSeen_[v]; }
+
+std::string_view Graph::Frozen::getLabel(Vertex v) const {
+    return std::string_view(labels_).substr(labelOffsets_[v], labelOffsets_[v + 1] - labelOffsets_[v]);
+}
+
+std::span<const std::uint32_t> Graph::Frozen::getOutEdges(Vertex v) const {
+    return std::span(edgeTargets_).subspan(edgeOffsets_[v], edgeOffsets_[v + 1] - edgeOffsets_[v]);
+}
+
+std::span<const std::uint32_t> Graph::Frozen::getBaseVertices() const {
+    return bases_;
+}
 
-    std::vector<VariantItem> items = getVariantItemsForBase(baseName);
-    std::sort(items.begin(), items.end(), fewerFlagsThenEarlier);
+std::span<const std::uint32_t> Graph::Frozen::getVariantsForBase(Vertex baseVertex) const {
+    return std::span(variants_).subspan(variantOffsets_[baseVertex],
+                                        variantOffsets_[baseVertex + 1] - variantOffsets_[baseVertex]);
+}
 
+std::vector<Graph::Vertex> Graph::getBaseVertices() const {
     std::vector<Vertex> out;
-    out.reserve(items.size());
-    for (const auto& it : items) out.push_back(it.vertex);
+    out.reserve(constellations_.size());
+    for (const auto& kv : constellations_) {
+        out.push_back(kv.second.vertex);
+    }
+    // Vertex order, independent of hash iteration.
+    std::sort(out.begin(), out.end());
     return out;
 }
+
+const std::vector<Graph::Vertex>& Graph::getVariantsForBase(Vertex baseVertex) const {
+    return constellations_.at(graph_[baseVertex].base).variantsByFlagCount;
+}
@@ -0,0 +1,111 @@
+#include "HeavyHitters.hpp"
+
+#include <algorithm>
+
+using namespace stars;
+
+HeavyHitters::HeavyHitters(std::size_t budgetBytes) : budget_(budgetBytes) {}
+
+std::size_t HeavyHitters::costOf(std::string_view key) {
+    return kEntryOverhead + key.size();
+}
+
+void HeavyHitters::offer(std::string_view key) {
+    ++total_;
+    if (auto it = index_.find(key); it != index_.end()) {
+        ++heap_[it->second].count;
+        siftDown(it->second);
+        return;
+    }
+
+    const std::size_t cost = costOf(key);
+    // A longer key may need several victims.
+    while (used_ + cost > budget_ && !heap_.empty()) evictMin();
+    if (used_ + cost > budget_) {
+        ++dropped_;
+        return;
+    }
+
+    // Space-Saving: the newcomer may have been counted and evicted before, so it starts from the
+    // largest count ever evicted, which becomes its error. Inheriting only this offer's victim would
+    // under-count keys that re-enter in the room a long key's extra evictions freed.
+    const std::uint64_t inherited = maxEvicted_;
+    auto* node = &*index_.emplace(std::string(key), heap_.size()).first;
+    used_ += cost;
+    heap_.push_back(Slot{inherited + 1, inherited, node});
+    siftUp(heap_.size() - 1);
+}
+
+bool HeavyHitters::contains(std::string_view key) const {
+    return index_.find(key) != index_.end();
+}
+
+std::vector<HeavyHitters::Entry> HeavyHitters::getTop(std::size_t k) const {
+    std::vector<Entry> out;
+    out.reserve(heap_.size());
+    for (const Slot& slot : heap_) out.push_back(Entry{slot.node->first, slot.count, slot.error});
+
+    auto byCount = [](const Entry& a, const Entry& b) {
+        if (a.count != b.count) return a.count > b.count;
+        return a.key < b.key;
+    };
+    if (k < out.size()) {
+        std::partial_sort(out.begin(), out.begin() + static_cast<std::ptrdiff_t>(k), out.end(), byCount);
+        out.resize(k);
+    } else {
+        std::sort(out.begin(), out.end(), byCount);
+    }
+    return out;
+}
+
+std::uint64_t HeavyHitters::getTotal() const {
+    return total_;
+}
+
+std::uint64_t HeavyHitters::getMaxError() const {
+    return maxEvicted_ + dropped_;
+}
+
+void HeavyHitters::evictMin() {
+    const Slot victim = heap_[0];
+    maxEvicted_ = std::max(maxEvicted_, victim.count);
+    used_ -= costOf(victim.node->first);
+    index_.erase(index_.find(victim.node->first));
+
+    const Slot last = heap_.back();
+    heap_.pop_back();
+    if (!heap_.empty()) {
+        place(0, last);
+        siftDown(0);
+    }
+}
+
+void HeavyHitters::place(std::size_t pos, Slot slot) {
+    heap_[pos] = slot;
+    slot.node->second = pos;
+}
+
+void HeavyHitters::siftDown(std::size_t pos) {
+    const Slot slot = heap_[pos];
+    const std::size_t n = heap_.size();
+    for (;;) {
+        std::size_t child = 2 * pos + 1;
+        if (child >= n) break;
+        if (child + 1 < n && heap_[child + 1].count < heap_[child].count) ++child;
+        if (heap_[child].count >= slot.count) break;
+        place(pos, heap_[child]);
+        pos = child;
+    }
+    place(pos, slot);
+}
+
+void HeavyHitters::siftUp(std::size_t pos) {
+    const Slot slot = heap_[pos];
+    while (pos > 0) {
+        const std::size_t parent = (pos - 1) / 2;
+        if (heap_[parent].count <= slot.count) break;
+        place(pos, heap_[parent]);
+        pos = parent;
+    }
+    place(pos, slot);
+}
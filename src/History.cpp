@@ -1,25 +1,717 @@
 #include "History.hpp"
 
-#include <fstream>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <boost/iostreams/categories.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/filter/zstd.hpp>
+#include <boost/iostreams/filtering_streambuf.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <mutex>
 #include <stdexcept>
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define STARS_HAS_X86_SIMD 1
+#endif
+
 using namespace stars;
 
+namespace {
+
+/// Closes the descriptor on scope exit.
+struct FileDescriptor {
+    int fd;
+    explicit FileDescriptor(int f) : fd(f) {}
+    ~FileDescriptor() {
+        if (fd >= 0) ::close(fd);
+    }
+    FileDescriptor(const FileDescriptor&) = delete;
+    FileDescriptor& operator=(const FileDescriptor&) = delete;
+};
+
+/// Append bytes [from, to) of a file, or fewer if it ends sooner. Throws on error.
+void readRange(int fd, std::size_t from, std::size_t to, std::string& out) {
+    const std::size_t start = out.size();
+    out.resize(start + (to - from));
+    std::size_t used = 0;
+    while (used < to - from) {
+        const ssize_t n = ::pread(fd, out.data() + start + used, to - from - used, static_cast<off_t>(from + used));
+        if (n == 0) break;
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error(std::string("Cannot read history file: ") + std::strerror(errno));
+        }
+        used += static_cast<std::size_t>(n);
+    }
+    out.resize(start + used);
+}
+
+/// Boost.Iostreams source over a descriptor; bytes already read to sniff the format are replayed first.
+class DescriptorSource {
+   public:
+    using char_type = char;
+    using category = boost::iostreams::source_tag;
+
+    DescriptorSource(int fd, std::string head) : fd_(fd), head_(std::move(head)) {}
+
+    std::streamsize read(char* s, std::streamsize n) {
+        if (headPos_ < head_.size()) {
+            const std::size_t count = std::min(head_.size() - headPos_, static_cast<std::size_t>(n));
+            std::memcpy(s, head_.data() + headPos_, count);
+            headPos_ += count;
+            return static_cast<std::streamsize>(count);
+        }
+        for (;;) {
+            const ssize_t got = ::read(fd_, s, static_cast<std::size_t>(n));
+            if (got > 0) return got;
+            if (got == 0) return -1;
+            if (errno != EINTR) {
+                throw std::runtime_error(std::string("Cannot read history input: ") + std::strerror(errno));
+            }
+        }
+    }
+
+   private:
+    int fd_;
+    std::string head_;
+    std::size_t headPos_ = 0;
+};
+
+/// Line index under construction; the SIMD kernels feed it newline and "special" byte masks.
+struct LineSink {
+    std::vector<std::string_view>& lines;
+    std::vector<bool>& skippable;
+    const char* lineStart;
+    bool startPending = true;  ///< Current line's first byte not classified yet.
+    bool startSkippable = false;
+
+    void emit(const char* lineEnd) {
+        lines.emplace_back(lineStart, static_cast<std::size_t>(lineEnd - lineStart));
+        skippable.push_back(startSkippable);
+    }
+
+    /// Consume one block: bit i of newlines marks '\n', bit i of specials marks '\n' or '#'.
+    void consumeBlock(const char* block, std::uint32_t newlines, std::uint32_t specials, unsigned width) {
+        if (startPending) {
+            startSkippable = (specials & 1u) != 0;
+            startPending = false;
+        }
+        while (newlines) {
+            const unsigned bit = static_cast<unsigned>(__builtin_ctz(newlines));
+            emit(block + bit);
+            lineStart = block + bit + 1;
+            if (bit + 1 == width) {
+                startPending = true;
+            } else {
+                startSkippable = ((specials >> (bit + 1)) & 1u) != 0;
+            }
+            newlines &= newlines - 1;
+        }
+    }
+
+    /// Byte-at-a-time tail and fallback path.
+    void consumeScalar(const char* p, const char* end) {
+        for (; p < end; ++p) {
+            if (startPending) {
+                startSkippable = (*p == '\n' || *p == '#');
+                startPending = false;
+            }
+            if (*p == '\n') {
+                emit(p);
+                lineStart = p + 1;
+                startPending = true;
+            }
+        }
+    }
+
+    void finish(const char* end) {
+        // Last line without a trailing newline, as std::getline would return it.
+        if (lineStart < end) emit(end);
+    }
+};
+
+void scanScalar(LineSink& sink, const char* begin, const char* end) {
+    sink.consumeScalar(begin, end);
+}
+
+#ifdef STARS_HAS_X86_SIMD
+void scanSse2(LineSink& sink, const char* begin, const char* end) {
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i hash = _mm_set1_epi8('#');
+
+    const char* p = begin;
+    for (; end - p >= 16; p += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        const __m128i isNewline = _mm_cmpeq_epi8(v, newline);
+        const __m128i isSpecial = _mm_or_si128(isNewline, _mm_cmpeq_epi8(v, hash));
+        sink.consumeBlock(p,
+                          static_cast<std::uint32_t>(_mm_movemask_epi8(isNewline)),
+                          static_cast<std::uint32_t>(_mm_movemask_epi8(isSpecial)),
+                          16);
+    }
+    sink.consumeScalar(p, end);
+}
+
+__attribute__((target("avx2"))) void scanAvx2(LineSink& sink, const char* begin, const char* end) {
+    const __m256i newline = _mm256_set1_epi8('\n');
+    const __m256i hash = _mm256_set1_epi8('#');
+
+    const char* p = begin;
+    for (; end - p >= 32; p += 32) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        const __m256i isNewline = _mm256_cmpeq_epi8(v, newline);
+        const __m256i isSpecial = _mm256_or_si256(isNewline, _mm256_cmpeq_epi8(v, hash));
+        sink.consumeBlock(p,
+                          static_cast<std::uint32_t>(_mm256_movemask_epi8(isNewline)),
+                          static_cast<std::uint32_t>(_mm256_movemask_epi8(isSpecial)),
+                          32);
+    }
+    sink.consumeScalar(p, end);
+}
+#endif
+
+using ScanFunction = void (*)(LineSink&, const char*, const char*);
+
+/// Pick the widest kernel the running CPU supports, once.
+ScanFunction selectScanKernel() {
+#ifdef STARS_HAS_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return scanAvx2;
+    if (__builtin_cpu_supports("sse2")) return scanSse2;
+#endif
+    return scanScalar;
+}
+
+/// Kernel forced by History::setScanKernel(); null for the detected one.
+std::atomic<ScanFunction> forcedScanKernel{nullptr};
+
+}  // namespace
+
+/// Sequential reader for input that is not mapped: owns the descriptor and the decompressor chain.
+struct History::Decoder {
+    FileDescriptor file;
+    boost::iostreams::filtering_istreambuf stream;
+    bool finished = false;
+
+    Decoder(int fd, std::string head, Compression compression) : file(fd) {
+        if (compression == Compression::Gzip) stream.push(boost::iostreams::gzip_decompressor());
+        if (compression == Compression::Zstd) stream.push(boost::iostreams::zstd_decompressor());
+        stream.push(DescriptorSource(fd, std::move(head)));
+    }
+
+    /// Fill up to n bytes; fewer only at the end of the input.
+    std::size_t read(char* s, std::size_t n) {
+        if (finished) return 0;
+        try {
+            const auto got = static_cast<std::size_t>(stream.sgetn(s, static_cast<std::streamsize>(n)));
+            finished = got < n;
+            return got;
+        } catch (const std::ios_base::failure& e) {
+            throw std::runtime_error(std::string("Cannot decompress history input: ") + e.what());
+        }
+    }
+};
+
+/// Decoded batch buffers, handed back by the last view holder and reused with their capacity.
+struct History::ChunkPool {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<std::string>> free;
+};
+
+History::History() = default;
+
+History::~History() {
+    if (watchFd_ >= 0) ::close(watchFd_);
+    if (fileFd_ >= 0) ::close(fileFd_);
+}
+
 /// Load raw lines from a file. Throws on error.
 void History::loadFromFile(const std::string& path) {
-    std::ifstream in(path);
-    if (!in.is_open()) {
+    openFile(path, nullptr);
+}
+
+bool History::loadFromFile(const std::string& path, const Fingerprint& prefix) {
+    return openFile(path, &prefix);
+}
+
+bool History::openFile(const std::string& path, const Fingerprint* prefix) {
+    const bool standardInput = path == "-";
+    FileDescriptor file(standardInput ? ::fcntl(STDIN_FILENO, F_DUPFD_CLOEXEC, 0)
+                                      : ::open(path.c_str(), O_RDONLY | O_CLOEXEC));
+    if (file.fd < 0) {
         throw std::runtime_error("Cannot open history file: " + path);
     }
 
-    rawLines_.clear();
-    std::string line;
+    struct stat st {};
+    if (::fstat(file.fd, &st) != 0) {
+        throw std::runtime_error("Cannot stat history file: " + path + ": " + std::strerror(errno));
+    }
+
+    lines_.clear();
+    skippable_.clear();
+    data_.reset();
+    decoder_.reset();
+    carry_.clear();
+    size_ = 0;
+    dataOffset_ = 0;
+    firstLineNumber_ = 0;
+
+    path_ = path;
+    device_ = st.st_dev;
+    inode_ = st.st_ino;
+    modifiedNs_ = static_cast<std::int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+    // Standard input has no path to validate a snapshot against, even when redirected from a file.
+    regular_ = S_ISREG(st.st_mode) && !standardInput;
+    rereadable_ = regular_;
+
+    // Sniff the magic bytes; the decoder replays them, a mapping ignores the read position.
+    std::string head(4, '\0');
+    std::size_t headSize = 0;
+    while (headSize < head.size()) {
+        const ssize_t n = ::read(file.fd, head.data() + headSize, head.size() - headSize);
+        if (n == 0) break;
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error("Cannot read history file: " + path + ": " + std::strerror(errno));
+        }
+        headSize += static_cast<std::size_t>(n);
+    }
+    head.resize(headSize);
+    compression_ = detectCompression(head);
+    // Decoded bytes do not match the file's, so compressed input is never cached.
+    if (compression_ != Compression::None) regular_ = false;
+
+    if (regular_ && st.st_size > 0) {
+        size_ = static_cast<std::size_t>(st.st_size);
+        data_ = mapFile(file.fd, size_);
+    }
+    if (!data_) {
+        // Pipes, FIFOs, devices, compressed files, or filesystems that refuse mmap.
+        size_ = 0;
+        decoder_ = std::make_unique<Decoder>(file.fd, std::move(head), compression_);
+        file.fd = -1;
+        if (!streaming_) {
+            data_ = readAll(*decoder_, size_);
+            decoder_.reset();
+        }
+    }
+    offset_ = size_;
+
+    // Resume after the prefix when the file still starts with the same bytes and has only grown.
+    bool resumed = prefix != nullptr && regular_ && data_ && prefix->path == path && prefix->size <= size_ &&
+                   (prefix->size == size_ ? prefix->modifiedNs == modifiedNs_ : prefix->endsWithNewline);
+    if (resumed) {
+        const std::size_t tail = std::min<std::size_t>(kTailBytes, prefix->size);
+        resumed = hashBytes(std::string_view(data_.get() + prefix->size - tail, tail)) == prefix->tailHash;
+    }
+
+    const std::size_t from = resumed ? prefix->size : 0;
+    if (resumed) firstLineNumber_ = prefix->lineCount;
+    if (streaming_) {
+        scanOffset_ = streamStart_ = from;
+        streamFirstLine_ = firstLineNumber_;
+    } else {
+        scanLines(from);
+    }
+    return resumed;
+}
+
+void History::setStreaming(bool streaming) {
+    streaming_ = streaming;
+}
+
+bool History::readBatch(std::size_t maxBytes) {
+    firstLineNumber_ += lines_.size();
+    lines_.clear();
+    skippable_.clear();
+    if (decoder_) return readStreamBatch(maxBytes);
+    if (!data_ || scanOffset_ >= size_) return false;
+
+    // Cut after the last newline inside the budget; a longer line extends the batch to its end.
+    const char* base = data_.get();
+    std::size_t cut = size_;
+    if (size_ - scanOffset_ > maxBytes) {
+        if (const void* nl = ::memrchr(base + scanOffset_, '\n', maxBytes)) {
+            cut = static_cast<std::size_t>(static_cast<const char*>(nl) - base) + 1;
+        } else if (const void* next = std::memchr(base + scanOffset_ + maxBytes, '\n',
+                                                  size_ - scanOffset_ - maxBytes)) {
+            cut = static_cast<std::size_t>(static_cast<const char*>(next) - base) + 1;
+        }
+    }
+
+    scanLines(scanOffset_, cut);
+    scanOffset_ = cut;
+    return true;
+}
+
+bool History::readStreamBatch(std::size_t maxBytes) {
+    constexpr std::size_t kReadBytes = 64 * 1024;
+    if (!pool_) pool_ = std::make_shared<ChunkPool>();
+
+    std::unique_ptr<std::string> chunk;
+    {
+        std::lock_guard lock(pool_->mutex);
+        if (!pool_->free.empty()) {
+            chunk = std::move(pool_->free.back());
+            pool_->free.pop_back();
+        }
+    }
+    if (!chunk) chunk = std::make_unique<std::string>();
+    chunk->assign(carry_);
+    carry_.clear();
+
+    // Decode until the chunk holds maxBytes and a newline, or the input ends.
+    std::size_t cut = std::string::npos;
+    while (!decoder_->finished) {
+        const std::size_t used = chunk->size();
+        chunk->resize(used + kReadBytes);
+        chunk->resize(used + decoder_->read(chunk->data() + used, kReadBytes));
+        if (chunk->size() >= maxBytes) {
+            if (const void* nl = ::memrchr(chunk->data(), '\n', chunk->size())) {
+                cut = static_cast<std::size_t>(static_cast<const char*>(nl) - chunk->data()) + 1;
+                break;
+            }
+        }
+    }
+    if (cut == std::string::npos) cut = chunk->size();
+    if (cut == 0) {
+        std::lock_guard lock(pool_->mutex);
+        pool_->free.push_back(std::move(chunk));
+        return false;
+    }
+    carry_.assign(*chunk, cut);
+    chunk->resize(cut);
+
+    // The chunk returns to the pool once the last holder of its views lets go.
+    std::string* raw = chunk.release();
+    data_ = std::shared_ptr<const char>(raw->data(), [pool = pool_, raw](const char*) {
+        try {
+            std::lock_guard lock(pool->mutex);
+            pool->free.emplace_back(raw);
+        } catch (...) {
+            delete raw;
+        }
+    });
+    size_ = cut;
+    dataOffset_ = offset_;
+    offset_ += cut;
+    scanLines();
+    return true;
+}
+
+void History::restartBatches() {
+    if (decoder_) {
+        // A pipe reopened by name (say /dev/fd/63) is already drained and would read as empty.
+        if (!rereadable_) throw std::runtime_error("Cannot rewind history input: " + path_ + " can only be read once");
+        openFile(path_, nullptr);
+        return;
+    }
+    lines_.clear();
+    skippable_.clear();
+    scanOffset_ = streamStart_;
+    firstLineNumber_ = streamFirstLine_;
+}
+
+bool History::isReadOnce(const std::string& path) {
+    struct stat st {};
+    return path == "-" || (::stat(path.c_str(), &st) == 0 && !S_ISREG(st.st_mode));
+}
+
+History::Fingerprint History::getFingerprint() const {
+    Fingerprint out;
+    // Not cacheable: pipes, or no bytes in memory that end at the current offset.
+    if (!regular_ || offset_ < dataOffset_ || (!data_ && offset_ > 0)) return out;
+
+    const std::size_t covered = offset_ - dataOffset_;
+    const std::size_t tail = std::min<std::size_t>(kTailBytes, offset_);
+    if (covered < tail) return out;  // appended segment too short to hash the tail from memory
+
+    out.path = path_;
+    out.size = offset_;
+    out.modifiedNs = modifiedNs_;
+    out.tailHash = hashBytes(std::string_view(data_.get() + covered - tail, tail));
+    out.lineCount = firstLineNumber_ + lines_.size();
+    out.endsWithNewline = covered == 0 || data_.get()[covered - 1] == '\n';
+    return out;
+}
+
+std::string History::getCacheName(const std::string& path) {
+    std::error_code ec;
+    const auto absolute = std::filesystem::absolute(path, ec);
+    const std::uint64_t h = hashBytes(ec ? path : absolute.string());
+
+    static const char* digits = "0123456789abcdef";
+    std::string name(16, '0');
+    for (std::size_t i = 0; i < 16; ++i) name[15 - i] = digits[(h >> (4 * i)) & 0xF];
+    return name;
+}
+
+std::uint64_t History::hashBytes(std::string_view bytes) {
+    std::uint64_t h = 0xcbf29ce484222325ull;
+    for (unsigned char c : bytes) {
+        h ^= c;
+        h *= 0x100000001b3ull;
+    }
+    return h;
+}
 
-    while (std::getline(in, line)) {
-        rawLines_.push_back(line);
+void History::follow() {
+    if (path_.empty()) {
+        throw std::runtime_error("Cannot follow history: nothing loaded");
     }
+    if (path_ == "-" || compression_ != Compression::None) {
+        throw std::runtime_error("Cannot follow history: " + path_ + " is not a plain file");
+    }
+
+    watchFd_ = ::inotify_init1(IN_CLOEXEC);
+    if (watchFd_ < 0) {
+        throw std::runtime_error(std::string("Cannot start inotify: ") + std::strerror(errno));
+    }
+
+    // The directory watch catches rotation: a new file created or moved in under the same name.
+    std::filesystem::path directory = std::filesystem::path(path_).parent_path();
+    if (directory.empty()) directory = ".";
+    directoryWatch_ = ::inotify_add_watch(watchFd_, directory.c_str(), IN_CREATE | IN_MOVED_TO);
+    if (directoryWatch_ < 0) {
+        throw std::runtime_error("Cannot watch " + directory.string() + ": " + std::strerror(errno));
+    }
+
+    watchFile();
+
+    // Hold the file open, so what is written to it up to a rotation can still be read afterwards.
+    FileDescriptor file(::open(path_.c_str(), O_RDONLY | O_CLOEXEC));
+    struct stat st {};
+    if (file.fd >= 0 && ::fstat(file.fd, &st) == 0 && st.st_dev == device_ && st.st_ino == inode_) {
+        if (fileFd_ >= 0) ::close(fileFd_);
+        fileFd_ = file.fd;
+        file.fd = -1;
+    }
+}
+
+void History::watchFile() {
+    // The replaced file's watch would otherwise stay for as long as that inode lives. Removing a
+    // watch the kernel already dropped (file deleted) fails harmlessly.
+    if (fileWatch_ >= 0) ::inotify_rm_watch(watchFd_, fileWatch_);
+    fileWatch_ = ::inotify_add_watch(watchFd_, path_.c_str(), IN_MODIFY | IN_ATTRIB | IN_MOVE_SELF | IN_DELETE_SELF);
+}
+
+void History::waitForChange() {
+    while (!readWatchEvents()) {
+    }
+}
+
+bool History::waitForChange(std::chrono::milliseconds timeout) {
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    for (;;) {
+        const auto left =
+            std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        struct pollfd watch = {watchFd_, POLLIN, 0};
+        const int ready = ::poll(&watch, 1, static_cast<int>(std::max<std::int64_t>(0, left.count())));
+        if (ready < 0) {
+            if (errno == EINTR) return false;  // Let the caller see the signal.
+            throw std::runtime_error(std::string("Cannot poll inotify events: ") + std::strerror(errno));
+        }
+        if (ready == 0) return false;
+        if (readWatchEvents()) return true;
+    }
+}
+
+/// Read one batch of inotify events; whether any of them touched the watched file.
+bool History::readWatchEvents() {
+    const std::string name = std::filesystem::path(path_).filename().string();
+    alignas(struct inotify_event) char buffer[4096];
+
+    ssize_t n;
+    do {
+        n = ::read(watchFd_, buffer, sizeof(buffer));
+    } while (n < 0 && errno == EINTR);
+    if (n < 0) throw std::runtime_error(std::string("Cannot read inotify events: ") + std::strerror(errno));
+
+    bool changed = false;
+    for (ssize_t pos = 0; pos < n;) {
+        const auto* event = reinterpret_cast<const struct inotify_event*>(buffer + pos);
+        if (event->wd == directoryWatch_) {
+            if (event->len > 0 && name == event->name) {
+                watchFile();
+                changed = true;
+            }
+        } else {
+            changed = true;
+        }
+        pos += static_cast<ssize_t>(sizeof(struct inotify_event) + event->len);
+    }
+    return changed;
+}
+
+std::size_t History::readAppended() {
+    // Numbering continues after the lines handed out by the previous read.
+    firstLineNumber_ += lines_.size();
+    lines_.clear();
+    skippable_.clear();
+    data_.reset();
+    size_ = 0;
+
+    FileDescriptor file(::open(path_.c_str(), O_RDONLY | O_CLOEXEC));
+    if (file.fd < 0) return 0;  // Mid-rotation: the new file shows up with a later event.
+
+    struct stat st {};
+    if (::fstat(file.fd, &st) != 0) {
+        throw std::runtime_error("Cannot stat history file: " + path_ + ": " + std::strerror(errno));
+    }
+
+    auto buffer = std::make_shared<std::string>();
+    const auto fileSize = static_cast<std::size_t>(st.st_size);
+    if (st.st_dev != device_ || st.st_ino != inode_) {
+        // Rotated: a different file now lives at the path, read it from the start. When following,
+        // first drain what reached the old file before the rename; nothing will complete its last
+        // line any more, so it ends there.
+        if (fileFd_ >= 0) {
+            struct stat old {};
+            if (::fstat(fileFd_, &old) == 0 && static_cast<std::size_t>(old.st_size) > offset_) {
+                readRange(fileFd_, offset_, static_cast<std::size_t>(old.st_size), *buffer);
+                if (!buffer->empty() && buffer->back() != '\n') buffer->push_back('\n');
+            }
+            ::close(fileFd_);
+            fileFd_ = file.fd;
+            file.fd = -1;
+        }
+        device_ = st.st_dev;
+        inode_ = st.st_ino;
+        offset_ = 0;
+    } else if (fileSize < offset_) {
+        // Truncated and possibly rewritten in place: take its current end as the new baseline
+        // rather than counting rewritten commands twice.
+        offset_ = fileSize;
+        return 0;
+    }
+    const std::size_t drained = buffer->size();
+    const int fd = file.fd >= 0 ? file.fd : fileFd_;
+    if (fileSize > offset_) readRange(fd, offset_, fileSize, *buffer);
+
+    // Only complete lines; a partially written one is picked up by the next read.
+    const std::size_t lastNewline = std::string_view(*buffer).substr(drained).rfind('\n');
+    const std::size_t complete = lastNewline == std::string_view::npos ? 0 : lastNewline + 1;
+    buffer->resize(drained + complete);
+    if (buffer->empty()) return 0;
+
+    size_ = buffer->size();
+    data_ = std::shared_ptr<const char>(buffer, buffer->data());
+    scanLines();
+    // From here on data_ covers only the current file, as getFingerprint() expects; the aliasing
+    // pointer still keeps the drained lines alive.
+    data_ = std::shared_ptr<const char>(buffer, buffer->data() + drained);
+    size_ = complete;
+    dataOffset_ = offset_;
+    offset_ += complete;
+    return lines_.size();
+}
+
+std::shared_ptr<const char> History::mapFile(int fd, std::size_t size) {
+    void* addr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED) return nullptr;
+    ::madvise(addr, size, MADV_SEQUENTIAL);
+
+    return std::shared_ptr<const char>(static_cast<const char*>(addr), [size](const char* p) {
+        ::munmap(const_cast<char*>(p), size);
+    });
+}
+
+std::shared_ptr<const char> History::readAll(Decoder& decoder, std::size_t& size) {
+    auto buffer = std::make_shared<std::string>();
+    std::size_t used = 0;
+    buffer->resize(64 * 1024);
+
+    while (!decoder.finished) {
+        if (used == buffer->size()) buffer->resize(buffer->size() * 2);
+        used += decoder.read(buffer->data() + used, buffer->size() - used);
+    }
+
+    buffer->resize(used);
+    size = used;
+    // Aliasing constructor: the view keeps the owning string alive.
+    return std::shared_ptr<const char>(buffer, buffer->data());
+}
+
+/// Build the line index in one vectorized pass, splitting on '\n' like std::getline
+/// (a trailing newline does not produce an empty last line) and flagging empty and '#' lines.
+void History::scanLines(std::size_t from, std::size_t to) {
+    static const ScanFunction detected = selectScanKernel();
+    const ScanFunction forced = forcedScanKernel.load(std::memory_order_relaxed);
+    const ScanFunction kernel = forced ? forced : detected;
+
+    to = std::min(to, size_);
+    const char* begin = data_.get() + from;
+    const char* end = data_.get() + to;
+
+    // Rough pre-size; typical shell history lines are a few dozen bytes.
+    lines_.reserve((to - from) / 24 + 1);
+
+    LineSink sink{lines_, skippable_, begin};
+    if (begin < end) kernel(sink, begin, end);
+    sink.finish(end);
+}
+
+bool History::setScanKernel(ScanKernel kernel) {
+    ScanFunction function = nullptr;
+    switch (kernel) {
+        case ScanKernel::Auto:
+            break;
+        case ScanKernel::Scalar:
+            function = scanScalar;
+            break;
+#ifdef STARS_HAS_X86_SIMD
+        case ScanKernel::Sse2:
+            __builtin_cpu_init();
+            if (!__builtin_cpu_supports("sse2")) return false;
+            function = scanSse2;
+            break;
+        case ScanKernel::Avx2:
+            __builtin_cpu_init();
+            if (!__builtin_cpu_supports("avx2")) return false;
+            function = scanAvx2;
+            break;
+#endif
+        default:
+            return false;
+    }
+    forcedScanKernel.store(function, std::memory_order_relaxed);
+    return true;
+}
+
+const std::vector<std::string_view>& History::getLines() const {
+    return lines_;
+}
+
+std::shared_ptr<const char> History::getData() const {
+    return data_;
+}
+
+History::Compression History::getCompression() const {
+    return compression_;
+}
+
+History::Compression History::detectCompression(std::string_view head) {
+    if (head.size() >= 2 && head[0] == '\x1f' && head[1] == '\x8b') return Compression::Gzip;
+    if (head.size() >= 4 && head.substr(0, 4) == std::string_view("\x28\xb5\x2f\xfd", 4)) return Compression::Zstd;
+    return Compression::None;
+}
+
+const std::vector<bool>& History::getSkippable() const {
+    return skippable_;
 }
 
-const std::vector<std::string>& History::getLines() const {
-    return rawLines_;
+std::size_t History::getFirstLineNumber() const {
+    return firstLineNumber_;
 }
@@ -1,88 +1,502 @@
 #include "Layout.hpp"
 
 #include <algorithm>
+#include <array>
+#include <barrier>
+#include <cmath>
+#include <limits>
+#include <thread>
+#include <vector>
 
 using namespace stars;
 
+namespace {
+
+constexpr std::size_t kHorizStep = 20;   // columns between chain levels
+constexpr std::size_t kRowStep = 2;      // rows between slot rows, leaving one for connectors
+constexpr std::size_t kLabelGap = 1;     // free cells kept after a label
+constexpr std::size_t kColumnGap = 2;    // columns between packed constellations
+constexpr std::size_t kRowGap = 1;       // rows between packed constellations
+
+constexpr float kSpringScale = 0.8f;     // ideal edge length relative to sqrt(area / stars)
+constexpr float kGravity = 0.02f;        // pull towards the canvas centre
+constexpr float kTheta = 0.9f;           // Barnes-Hut opening criterion: cell size / distance
+constexpr int kMaxTreeDepth = 20;        // deeper bodies are merged (nearly coincident)
+constexpr int kSnapRadius = 4;           // rows searched around a star's cell when snapping
+
+bool rangeFree(const std::uint64_t* row, std::size_t begin, std::size_t end) {
+    for (std::size_t i = begin; i < end;) {
+        const std::size_t bit = i % 64;
+        const std::size_t count = std::min<std::size_t>(64 - bit, end - i);
+        const std::uint64_t mask = (count == 64 ? ~std::uint64_t{0} : ((std::uint64_t{1} << count) - 1)) << bit;
+        if (row[i / 64] & mask) return false;
+        i += count;
+    }
+    return true;
+}
+
+void fillRange(std::uint64_t* row, std::size_t begin, std::size_t end) {
+    for (std::size_t i = begin; i < end;) {
+        const std::size_t bit = i % 64;
+        const std::size_t count = std::min<std::size_t>(64 - bit, end - i);
+        row[i / 64] |= (count == 64 ? ~std::uint64_t{0} : ((std::uint64_t{1} << count) - 1)) << bit;
+        i += count;
+    }
+}
+
+}  // namespace
+
 /// Compute positions:
-/// - Bases: stacked vertically, left margin.
-/// - Variants: diagonals branching up/down alternating by order.
-/// - Specialization chains: placed progressively farther right.
-/// Keeps within canvas bounds.
-void Layout::compute(const Graph& graph,
+/// - Each shown constellation is arranged on its own (see arrange()) into a bounding box that
+///   includes its labels.
+/// - Boxes, most used first, are packed bottom-left onto a skyline of the canvas columns, which
+///   fills the canvas in columns of constellations ("galaxy"). Boxes that do not fit stay hidden.
+void Layout::compute(const Graph::Frozen& graph,
                      std::size_t width,
                      std::size_t height,
                      std::size_t maxConstellations) {
-    positions_.clear();
+    // Vertices are dense indices: resize keeps capacity, and the bitmap says which slots are live.
+    const std::size_t vertexCount = graph.getVertexCount();
+    positions_.resize(vertexCount);
+    placed_.assign((vertexCount + 63) / 64, 0);
     canvasWidth_ = width;
     canvasHeight_ = height;
+    if (width == 0 || height == 0) return;
+
+    // Most used constellations first; ties keep first-appearance order.
+    const auto allBases = graph.getBaseVertices();
+    std::vector<Graph::Vertex>& bases = bases_;
+    bases.assign(allBases.begin(), allBases.end());
+    const std::size_t shown = std::min(maxConstellations, bases.size());
+    std::partial_sort(bases.begin(), bases.begin() + static_cast<std::ptrdiff_t>(shown), bases.end(),
+                      [&graph](Graph::Vertex a, Graph::Vertex b) {
+                          if (graph.getFrequency(a) != graph.getFrequency(b)) {
+                              return graph.getFrequency(a) > graph.getFrequency(b);
+                          }
+                          return a < b;
+                      });
+    bases.resize(shown);
+
+    // Slot rows above and below the base such that any box fits the canvas height.
+    const std::size_t slotsPerSide = std::max<std::size_t>(1, (height - 1) / (2 * kRowStep));
+    skyline_.assign(width, 0);
+
+    for (Graph::Vertex base : bases) {
+        const Box box = arrange(graph, base, width, slotsPerSide);
+
+        std::size_t x = 0;
+        std::size_t y = 0;
+        if (!findSpot(box.width, box.height, x, y)) continue;
+
+        for (const LocalStar& star : local_) {
+            place(star.vertex, Position{x + star.x, y + static_cast<std::size_t>(star.row - box.top)});
+        }
+
+        // Raise the skyline under the box, keeping a gap to its right and below.
+        const std::size_t end = std::min(width, x + box.width + kColumnGap);
+        std::fill(skyline_.begin() + static_cast<std::ptrdiff_t>(x), skyline_.begin() + static_cast<std::ptrdiff_t>(end),
+                  y + box.height + kRowGap);
+    }
+
+    if (mode_ == Mode::Force) relax(graph);
+}
 
-    const std::size_t leftMargin = 1;
-    const std::size_t horizStep = 20;        // columns between chain nodes
-    const std::size_t vertStep = 4;          // rows between branches
-    const std::size_t constellationGap = 5;  // rows between constellations
-    std::size_t currentRow = 10;             // start row for first constellation
+/// Force mode: start from the packed layout and let the stars of the shown constellations settle
+/// under Fruchterman-Reingold forces: Barnes-Hut repulsion between all of them, springs along edges
+/// and a weak pull to the centre, cooling linearly over whichever of the iteration and time budgets
+/// runs out first. Workers each own a slice of the bodies; between steps the barrier's completion
+/// moves the stars and rebuilds the tree. snap() finally puts every star and label on free cells.
+void Layout::relax(const Graph::Frozen& graph) {
+    constexpr auto kNone = std::numeric_limits<std::uint32_t>::max();
+    bodies_.clear();
+    bodyOf_.assign(graph.getVertexCount(), kNone);
+    for (Graph::Vertex base : bases_) {
+        bodyOf_[base] = static_cast<std::uint32_t>(bodies_.size());
+        bodies_.push_back(base);
+        for (Graph::Vertex v : graph.getVariantsForBase(base)) {
+            bodyOf_[v] = static_cast<std::uint32_t>(bodies_.size());
+            bodies_.push_back(v);
+        }
+    }
+    const std::size_t n = bodies_.size();
+    if (n == 0) return;
 
-    auto bases = graph.getBaseVertices();
-    if (bases.size() > maxConstellations) {
-        bases.resize(maxConstellations);
+    const float width = static_cast<float>(canvasWidth_);
+    const float height = 2.0f * static_cast<float>(canvasHeight_);
+    px_.resize(n);
+    py_.resize(n);
+    dx_.resize(n);
+    dy_.resize(n);
+
+    // Stars the packer left out start on a golden-angle spiral around their base (or the centre).
+    std::size_t anchor = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        const Graph::Vertex v = bodies_[i];
+        if (graph.isBase(v)) anchor = i;
+        if (isPlaced(v)) {
+            px_[i] = static_cast<float>(positions_[v].x);
+            py_[i] = 2.0f * static_cast<float>(positions_[v].y);
+            continue;
+        }
+        const bool alone = anchor == i;
+        const float cx = alone ? width / 2 : px_[anchor];
+        const float cy = alone ? height / 2 : py_[anchor];
+        const float j = static_cast<float>(alone ? i + 1 : i - anchor);
+        const float angle = j * 2.39996323f;
+        px_[i] = std::clamp(cx + 3.0f * std::sqrt(j) * std::cos(angle), 0.0f, width - 1);
+        py_[i] = std::clamp(cy + 3.0f * std::sqrt(j) * std::sin(angle), 0.0f, height - 1);
     }
 
-    for (std::size_t bi = 0; bi < bases.size(); ++bi) {
-        auto base = bases[bi];
+    // Undirected springs between bodies, as CSR.
+    adjacencyOffsets_.assign(n + 1, 0);
+    for (std::size_t i = 0; i < n; ++i) {
+        for (Graph::Vertex dst : graph.getOutEdges(bodies_[i])) {
+            if (bodyOf_[dst] == kNone) continue;
+            ++adjacencyOffsets_[i + 1];
+            ++adjacencyOffsets_[bodyOf_[dst] + 1];
+        }
+    }
+    for (std::size_t i = 0; i < n; ++i) adjacencyOffsets_[i + 1] += adjacencyOffsets_[i];
+    adjacency_.resize(adjacencyOffsets_[n]);
+    for (std::size_t i = 0; i < n; ++i) {
+        for (Graph::Vertex dst : graph.getOutEdges(bodies_[i])) {
+            if (bodyOf_[dst] == kNone) continue;
+            adjacency_[adjacencyOffsets_[i]++] = bodyOf_[dst];
+            adjacency_[adjacencyOffsets_[bodyOf_[dst]]++] = static_cast<std::uint32_t>(i);
+        }
+    }
+    for (std::size_t i = n; i > 0; --i) adjacencyOffsets_[i] = adjacencyOffsets_[i - 1];
+    adjacencyOffsets_[0] = 0;
 
-        // Place base.
-        Position basePos{leftMargin, currentRow};
-        positions_[base] = basePos;
+    const float k = kSpringScale * std::sqrt(width * height / static_cast<float>(n));
+    const float startTemperature = std::max(width, height) / 10;
+    const auto start = std::chrono::steady_clock::now();
+    const auto deadline = start + forceTime_;
 
-        // Place variants alternating above/below diagonals.
-        auto variants = graph.getVariantsForBase(base);
+    std::size_t threads = threads_ != 0 ? threads_ : std::max(1u, std::thread::hardware_concurrency());
+    threads = std::min(threads, std::max<std::size_t>(1, n / kMinBodiesPerThread));
 
-        // For stable diagonals, we track the chain levels by flag count.
-        std::unordered_map<std::size_t, std::size_t> levelRightmostX;
+    std::size_t step = 0;
+    bool done = forceIterations_ == 0;
+    buildTree();
+    auto finishStep = [&]() noexcept {
+        // Cool by whichever budget is further spent, so a run the clock ends still settles. Elapsed
+        // time counts in whole steps' worth, keeping runs well inside it deterministic.
+        const auto now = std::chrono::steady_clock::now();
+        std::size_t spent = forceIterations_;
+        if (now < deadline) spent = static_cast<std::size_t>((now - start) * forceIterations_ / forceTime_);
+        const float progress = static_cast<float>(std::max(step, spent)) / static_cast<float>(forceIterations_);
+        const float temperature = startTemperature * (1.0f - std::min(progress, 1.0f));
+        for (std::size_t i = 0; i < n; ++i) {
+            const float length = std::sqrt(dx_[i] * dx_[i] + dy_[i] * dy_[i]);
+            if (length <= 0) continue;
+            const float scale = std::min(length, temperature) / length;
+            px_[i] = std::clamp(px_[i] + dx_[i] * scale, 0.0f, width - 1);
+            py_[i] = std::clamp(py_[i] + dy_[i] * scale, 0.0f, height - 1);
+        }
+        ++step;
+        done = step >= forceIterations_ || now >= deadline;
+        if (!done) buildTree();
+    };
 
-        bool goUp = true;
-        std::size_t branchIndex = 0;
-        for (auto v : variants) {
-            std::size_t level = graph.getBoostGraph()[v].flags.size();
-            std::size_t baseX = basePos.x + (level * horizStep);
-            std::size_t baseY = basePos.y;
+    std::barrier sync(static_cast<std::ptrdiff_t>(threads), finishStep);
+    auto work = [&](std::size_t t) {
+        const std::size_t begin = n * t / threads;
+        const std::size_t end = n * (t + 1) / threads;
+        while (!done) {
+            accumulateForces(begin, end, k);
+            sync.arrive_and_wait();
+        }
+    };
+    {
+        std::vector<std::jthread> workers;
+        workers.reserve(threads - 1);
+        for (std::size_t t = 1; t < threads; ++t) workers.emplace_back(work, t);
+        work(0);
+    }
 
-            std::size_t dy = (branchIndex + 1) * vertStep;
-            std::size_t y = goUp ? (baseY - dy) : (baseY + dy);
-            goUp = !goUp;  // alternate
+    snap(graph);
+}
 
-            // Clamp Y within canvas.
-            if (y < 1) y = 1;
-            if (y >= height - 2) y = height - 2;
+/// Insert every body into a fresh quadtree over their bounding square.
+void Layout::buildTree() {
+    const std::size_t n = bodies_.size();
+    const auto [minX, maxX] = std::minmax_element(px_.begin(), px_.begin() + static_cast<std::ptrdiff_t>(n));
+    const auto [minY, maxY] = std::minmax_element(py_.begin(), py_.begin() + static_cast<std::ptrdiff_t>(n));
+    const float half = std::max(*maxX - *minX, *maxY - *minY) / 2 + 1;
 
-            Position p{std::min(baseX, width - 4), y};
-            positions_[v] = p;
+    tree_.clear();
+    tree_.push_back(QuadNode{(*minX + *maxX) / 2, (*minY + *maxY) / 2, half, 0, 0, 0});
 
-            // Track rightmost x per level for specialization chaining.
-            levelRightmostX[level] = std::max(levelRightmostX[level], p.x);
+    for (std::size_t i = 0; i < n; ++i) {
+        const float x = px_[i];
+        const float y = py_[i];
+        std::size_t node = 0;
+        for (int depth = 0;; ++depth) {
+            if (tree_[node].child < 0) {
+                QuadNode& leaf = tree_[node];
+                if (leaf.mass == 0) {
+                    leaf.body = static_cast<std::int32_t>(i);
+                    leaf.sx = x;
+                    leaf.sy = y;
+                    leaf.mass = 1;
+                    break;
+                }
+                if (depth == kMaxTreeDepth) {
+                    leaf.body = -1;
+                    leaf.sx += x;
+                    leaf.sy += y;
+                    leaf.mass += 1;
+                    break;
+                }
 
-            ++branchIndex;
+                // Split: the resident body moves down into its quadrant.
+                const QuadNode resident = leaf;
+                const float quarter = resident.half / 2;
+                const auto first = static_cast<std::int32_t>(tree_.size());
+                for (int q = 0; q < 4; ++q) {
+                    tree_.push_back(QuadNode{resident.cx + ((q & 1) ? quarter : -quarter),
+                                             resident.cy + ((q & 2) ? quarter : -quarter), quarter, 0, 0, 0});
+                }
+                const int quadrant = (resident.sx >= resident.cx ? 1 : 0) | (resident.sy >= resident.cy ? 2 : 0);
+                QuadNode& moved = tree_[static_cast<std::size_t>(first + quadrant)];
+                moved.body = resident.body;
+                moved.sx = resident.sx;
+                moved.sy = resident.sy;
+                moved.mass = resident.mass;
+                tree_[node].child = first;
+                tree_[node].body = -1;
+            }
+
+            QuadNode& cell = tree_[node];
+            cell.sx += x;
+            cell.sy += y;
+            cell.mass += 1;
+            node = static_cast<std::size_t>(cell.child + (x >= cell.cx ? 1 : 0) + (y >= cell.cy ? 2 : 0));
         }
+    }
+}
+
+/// Displacement of bodies [begin, end) for one step; reads positions and the tree only.
+void Layout::accumulateForces(std::size_t begin, std::size_t end, float k) {
+    const float k2 = k * k;
+    const float centreX = static_cast<float>(canvasWidth_) / 2;
+    const float centreY = static_cast<float>(canvasHeight_);
+    std::array<std::int32_t, 4 * kMaxTreeDepth + 4> stack;
 
-        // Move row down for next constellation.
-        currentRow += std::max<std::size_t>(constellationGap, (branchIndex + 1) * vertStep + 2);
-        if (currentRow >= height - 1) {
-            break;  // stop if out of canvas
+    for (std::size_t i = begin; i < end; ++i) {
+        const float x = px_[i];
+        const float y = py_[i];
+        float fx = (centreX - x) * kGravity;
+        float fy = (centreY - y) * kGravity;
+
+        // Repulsion: far cells act as one body at their centre of mass.
+        std::size_t top = 0;
+        stack[top++] = 0;
+        while (top > 0) {
+            const QuadNode& cell = tree_[static_cast<std::size_t>(stack[--top])];
+            if (cell.mass == 0 || cell.body == static_cast<std::int32_t>(i)) continue;
+            float ddx = x - cell.sx / cell.mass;
+            float ddy = y - cell.sy / cell.mass;
+            float d2 = ddx * ddx + ddy * ddy;
+            if (cell.child >= 0 && 4 * cell.half * cell.half >= kTheta * kTheta * d2) {
+                for (int q = 0; q < 4; ++q) stack[top++] = cell.child + q;
+                continue;
+            }
+            if (d2 < 1e-4f) {
+                // Coincident: push apart in a direction that differs per body.
+                ddx = 0.01f * static_cast<float>(i % 7) - 0.03f;
+                ddy = 0.01f * static_cast<float>(i % 5) - 0.02f + 0.005f;
+                d2 = ddx * ddx + ddy * ddy;
+            }
+            const float f = k2 * cell.mass / d2;
+            fx += ddx * f;
+            fy += ddy * f;
+        }
+
+        // Springs along edges.
+        for (std::uint32_t a = adjacencyOffsets_[i]; a < adjacencyOffsets_[i + 1]; ++a) {
+            const float ddx = px_[adjacency_[a]] - x;
+            const float ddy = py_[adjacency_[a]] - y;
+            const float d = std::sqrt(ddx * ddx + ddy * ddy);
+            fx += ddx * d / k;
+            fy += ddy * d / k;
+        }
+
+        dx_[i] = fx;
+        dy_[i] = fy;
+    }
+}
+
+/// Put relaxed stars on the character grid, bases first: each takes the nearest cell (within
+/// kSnapRadius rows) whose star and label span is free in the canvas occupancy grid.
+void Layout::snap(const Graph::Frozen& graph) {
+    const std::size_t width = canvasWidth_;
+    const std::size_t height = canvasHeight_;
+    const std::size_t rowWords = (width + 63) / 64;
+    occupancy_.assign(height * rowWords, 0);
+    placed_.assign(placed_.size(), 0);
+
+    for (const bool bases : {true, false}) {
+        for (std::size_t i = 0; i < bodies_.size(); ++i) {
+            const Graph::Vertex v = bodies_[i];
+            if (graph.isBase(v) != bases) continue;
+
+            const std::size_t span = 1 + graph.getLabel(v).size() + kLabelGap;
+            const auto maxX = static_cast<std::ptrdiff_t>(width > span ? width - span : 0);
+            const auto wantX = std::min(static_cast<std::ptrdiff_t>(std::lround(px_[i])), maxX);
+            const auto wantY = static_cast<std::ptrdiff_t>(std::lround(py_[i] / 2));
+
+            // Rings of growing radius; a cell is twice as tall as wide, so rings span 2r columns.
+            bool placed = false;
+            for (int r = 0; r <= kSnapRadius && !placed; ++r) {
+                for (int dy = -r; dy <= r && !placed; ++dy) {
+                    for (int dx = -2 * r; dx <= 2 * r && !placed; ++dx) {
+                        if (std::max(std::abs(dy), (std::abs(dx) + 1) / 2) != r) continue;
+                        const std::ptrdiff_t x = wantX + dx;
+                        const std::ptrdiff_t y = wantY + dy;
+                        if (x < 0 || y < 0 || x > maxX || y >= static_cast<std::ptrdiff_t>(height)) continue;
+
+                        std::uint64_t* row = occupancy_.data() + static_cast<std::size_t>(y) * rowWords;
+                        const auto begin = static_cast<std::size_t>(x);
+                        const std::size_t end = std::min(width, begin + span);
+                        if (!rangeFree(row, begin, end)) continue;
+                        fillRange(row, begin, end);
+                        place(v, Position{begin, static_cast<std::size_t>(y)});
+                        placed = true;
+                    }
+                }
+            }
         }
     }
 }
 
+void Layout::setMode(Mode mode) {
+    mode_ = mode;
+}
+
+Layout::Mode Layout::getMode() const {
+    return mode_;
+}
+
+void Layout::setForceBudget(std::size_t iterations, std::chrono::milliseconds time) {
+    forceIterations_ = iterations;
+    forceTime_ = time;
+}
+
+void Layout::setThreads(std::size_t threads) {
+    threads_ = threads;
+}
+
+/// Arrange one constellation into local_:
+/// - Base: column 0 of the base row.
+/// - Variants: in their flag-count column (chain level), on the nearest free slot row, alternating
+///   above/below. A slot is free when the star and its label span are clear in the occupancy grid.
+/// - When every slot of a column is taken, the column repeats in a band further right.
+/// Variants that fit nowhere within width are left out.
+Layout::Box Layout::arrange(const Graph::Frozen& graph,
+                            Graph::Vertex base,
+                            std::size_t width,
+                            std::size_t slotsPerSide) {
+    local_.clear();
+
+    // Slot row s: 0 is the base row, odd rows go up and even rows down, kRowStep apart.
+    const std::size_t rowWords = (width + 63) / 64;
+    occupancy_.assign((2 * slotsPerSide + 1) * rowWords, 0);
+    auto slotRow = [&](std::size_t slot) { return occupancy_.data() + slot * rowWords; };
+    auto slotOffset = [](std::size_t slot) {
+        const auto k = static_cast<std::ptrdiff_t>((slot + 1) / 2 * kRowStep);
+        return slot % 2 == 1 ? -k : k;
+    };
+    auto labelEnd = [&](std::size_t x, Graph::Vertex v) {
+        return std::min(width, x + 1 + graph.getLabel(v).size());
+    };
+
+    Box box;
+    std::size_t right = labelEnd(0, base);
+    std::ptrdiff_t bottom = 0;
+    fillRange(slotRow(0), 0, std::min(width, right + kLabelGap));
+    local_.push_back(LocalStar{base, 0, 0});
+
+    const auto variants = graph.getVariantsForBase(base);
+    std::size_t maxLevel = 0;
+    for (Graph::Vertex v : variants) maxLevel = std::max(maxLevel, graph.getFlagCount(v));
+    const std::size_t bandWidth = (maxLevel + 1) * kHorizStep;
+
+    bool goUp = true;
+    for (Graph::Vertex v : variants) {
+        const std::size_t level = graph.getFlagCount(v);
+        bool placed = false;
+        for (std::size_t x = level * kHorizStep; x < width && !placed; x += bandWidth) {
+            const std::size_t end = labelEnd(x, v);
+            const std::size_t reserved = std::min(width, end + kLabelGap);
+            for (std::size_t k = 1; k <= slotsPerSide && !placed; ++k) {
+                for (std::size_t slot : {goUp ? 2 * k - 1 : 2 * k, goUp ? 2 * k : 2 * k - 1}) {
+                    if (!rangeFree(slotRow(slot), x, reserved)) continue;
+                    fillRange(slotRow(slot), x, reserved);
+                    const std::ptrdiff_t row = slotOffset(slot);
+                    local_.push_back(LocalStar{v, x, row});
+                    right = std::max(right, end);
+                    box.top = std::min(box.top, row);
+                    bottom = std::max(bottom, row);
+                    placed = true;
+                    break;
+                }
+            }
+        }
+        goUp = !goUp;  // alternate
+    }
+
+    box.width = right;
+    box.height = static_cast<std::size_t>(bottom - box.top) + 1;
+    return box;
+}
+
+/// Bottom-left skyline packing: the leftmost column span whose highest skyline row is lowest.
+/// A sliding-window maximum keeps the scan linear in the canvas width.
+bool Layout::findSpot(std::size_t width, std::size_t height, std::size_t& x, std::size_t& y) {
+    const std::size_t columns = skyline_.size();
+    if (width > columns) return false;
+
+    std::size_t bestY = canvasHeight_;
+    std::size_t head = 0;
+    window_.resize(columns);
+    std::size_t tail = 0;
+    for (std::size_t i = 0; i < columns; ++i) {
+        while (tail > head && skyline_[window_[tail - 1]] <= skyline_[i]) --tail;
+        window_[tail++] = i;
+        if (window_[head] + width <= i) ++head;
+        if (i + 1 < width) continue;
+
+        const std::size_t top = skyline_[window_[head]];
+        if (top < bestY) {
+            bestY = top;
+            x = i + 1 - width;
+        }
+    }
+    if (bestY + height > canvasHeight_) return false;
+    y = bestY;
+    return true;
+}
+
+void Layout::place(Graph::Vertex v, Position p) {
+    positions_[v] = p;
+    placed_[v / 64] |= std::uint64_t{1} << (v % 64);
+}
+
 Layout::Position Layout::getPosition(Graph::Vertex v) const {
-    auto it = positions_.find(v);
-    if (it != positions_.end()) return it->second;
+    if (isPlaced(v)) return positions_[v];
     return Position{0, 0};
 }
 
+bool Layout::isPlaced(Graph::Vertex v) const {
+    return v / 64 < placed_.size() && ((placed_[v / 64] >> (v % 64)) & 1u) != 0;
+}
+
 std::pair<std::size_t, std::size_t> Layout::getCanvasSize() const {
     return {canvasWidth_, canvasHeight_};
 }
 
-const std::unordered_map<Graph::Vertex, Layout::Position>& Layout::getPositions() const {
+const std::vector<Layout::Position>& Layout::getPositions() const {
     return positions_;
 }
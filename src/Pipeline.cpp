@@ -0,0 +1,364 @@
+#include "Pipeline.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <mutex>
+#include <semaphore>
+#include <string>
+#include <thread>
+#include <unordered_set>
+
+#include "HeavyHitters.hpp"
+
+using namespace stars;
+
+namespace {
+
+/// Lets string sets be probed with views, without a temporary string per command.
+struct ViewHash {
+    using is_transparent = void;
+    std::size_t operator()(std::string_view key) const { return std::hash<std::string_view>{}(key); }
+};
+
+}  // namespace
+
+Pipeline::Pipeline(std::size_t parsers, std::size_t batchBytes, std::size_t maxInFlight)
+    : parsers_(parsers != 0 ? parsers : std::max(1u, std::thread::hardware_concurrency())),
+      batchBytes_(std::max<std::size_t>(1, batchBytes)),
+      maxInFlight_(maxInFlight != 0 ? maxInFlight : 2 * parsers_ + 2) {}
+
+/// Stage layout (end of stream is one nullopt per parser):
+///   reader --Batch--> parsers --Parsed--> aggregator (calling thread)
+/// The reader takes a credit per batch and the aggregator returns it once the batch is folded, so
+/// at most maxInFlight batches are alive and sequence % maxInFlight indexes the reorder ring.
+std::size_t Pipeline::run(History& history, Graph& graph) {
+    Graph::Builder builder(graph, parsers_);
+    const std::size_t commands = run(history, [&builder](std::vector<Command>& batch) { builder.add(batch); });
+    builder.finish();
+    return commands;
+}
+
+std::size_t Pipeline::runTopK(History& history, Graph& graph, std::size_t k, std::size_t budgetBytes) {
+    bool first = true;
+    return topK(
+        [&](const Consumer& consume) {
+            if (!first) history.restartBatches();
+            first = false;
+            run(history, consume);
+        },
+        graph, k, budgetBytes, parsers_);
+}
+
+std::size_t Pipeline::runMergedTopK(const std::vector<std::string>& paths, Graph& graph, std::size_t k,
+                                    std::size_t budgetBytes) {
+    return topK([&](const Consumer& consume) { runMerged(paths, consume); }, graph, k, budgetBytes, parsers_);
+}
+
+std::size_t Pipeline::topK(const std::function<void(const Consumer&)>& pass, Graph& graph, std::size_t k,
+                           std::size_t budgetBytes, std::size_t threads) {
+    HeavyHitters bases(budgetBytes / 4);
+    HeavyHitters variants(budgetBytes - budgetBytes / 4);
+
+    // Variant key: base and sorted flags, NUL separated. A repeated flag is kept once, as the
+    // Graph's flag set does, so "ls -l -l" counts toward the variant of "ls -l".
+    std::string key;
+    auto variantKey = [&key](const Command& cmd) -> std::string_view {
+        key.assign(cmd.base);
+        for (std::size_t i = 0; i < cmd.flags.size(); ++i) {
+            if (i > 0 && cmd.flags[i] == cmd.flags[i - 1]) continue;  // Sorted, so repeats are adjacent.
+            key.push_back('\0');
+            key.append(cmd.flags[i]);
+        }
+        return key;
+    };
+
+    pass([&](std::vector<Command>& commands) {
+        for (const Command& cmd : commands) {
+            if (cmd.base.empty()) continue;
+            bases.offer(cmd.base);
+            variants.offer(variantKey(cmd));
+        }
+    });
+
+    std::unordered_set<std::string, ViewHash, std::equal_to<>> selected;
+    for (const auto& entry : bases.getTop(k)) selected.emplace(entry.key);
+
+    std::size_t kept = 0;
+    Graph::Builder builder(graph, threads);
+    pass([&](std::vector<Command>& commands) {
+        std::erase_if(commands, [&](const Command& cmd) {
+            return cmd.base.empty() || !selected.contains(cmd.base) ||
+                   !variants.contains(variantKey(cmd));
+        });
+        kept += commands.size();
+        builder.add(commands);
+    });
+    builder.finish();
+    return kept;
+}
+
+std::int64_t Pipeline::getLastTimestamp() const {
+    return lastTimestamp_;
+}
+
+Command::Format Pipeline::getFormat() const {
+    return format_;
+}
+
+std::size_t Pipeline::run(History& history, const Consumer& consume) {
+    BoundedQueue<std::optional<Batch>> batches(maxInFlight_);
+    BoundedQueue<std::optional<Parsed>> parsed(maxInFlight_);
+    std::counting_semaphore<> credits(static_cast<std::ptrdiff_t>(maxInFlight_));
+
+    std::atomic<bool> failed{false};
+    std::exception_ptr error;
+    std::mutex errorMutex;
+    auto fail = [&](std::exception_ptr e) {
+        std::lock_guard lock(errorMutex);
+        if (!error) error = std::move(e);
+        failed.store(true, std::memory_order_relaxed);
+    };
+
+    std::vector<std::jthread> workers;
+    workers.reserve(parsers_ + 1);
+
+    lastTimestamp_ = 0;
+    format_ = Command::Format::Bash;
+    workers.emplace_back([&] {
+        try {
+            bool continued = false;
+            for (std::size_t sequence = 0; !failed.load(std::memory_order_relaxed); ++sequence) {
+                credits.acquire();
+                if (!history.readBatch(batchBytes_)) {
+                    credits.release();
+                    break;
+                }
+                Batch batch;
+                batch.sequence = sequence;
+                batch.firstIndex = history.getFirstLineNumber();
+                batch.data = history.getData();
+                batch.lines = history.getLines();
+                batch.skippable = history.getSkippable();
+                if (sequence == 0) format_ = Command::detectFormat(batch.lines);
+                batch.continued = continued;
+                continued = !batch.lines.empty() && batch.lines.back().ends_with('\\');
+                // Epoch lines rule until the next one, so the time carries across batch boundaries.
+                batch.timestamp = lastTimestamp_;
+                lastTimestamp_ = Command::findLastTimestamp(batch.lines, lastTimestamp_);
+                batches.push(std::move(batch));
+            }
+        } catch (...) {
+            fail(std::current_exception());
+        }
+        for (std::size_t i = 0; i < parsers_; ++i) batches.push(std::nullopt);
+    });
+
+    for (std::size_t i = 0; i < parsers_; ++i) {
+        workers.emplace_back([&] {
+            while (auto batch = batches.pop()) {
+                Parsed out;
+                out.sequence = batch->sequence;
+                out.data = std::move(batch->data);
+                try {
+                    // format_ is set before the first batch is queued.
+                    if (format_ == Command::Format::Zsh) {
+                        out.commands =
+                            Command::parseZshLines(batch->lines, out.arena, batch->firstIndex, batch->continued);
+                    } else {
+                        out.commands = Command::parseLines(batch->lines, out.arena, batch->skippable,
+                                                           batch->firstIndex, 1, batch->timestamp);
+                    }
+                } catch (...) {
+                    fail(std::current_exception());
+                }
+                parsed.push(std::move(out));
+            }
+            parsed.push(std::nullopt);
+        });
+    }
+
+    // Aggregator: fold batches strictly in sequence so numbering matches a single append.
+    std::vector<std::optional<Parsed>> pending(maxInFlight_);
+    std::size_t next = 0;
+    std::size_t commandCount = 0;
+    for (std::size_t open = parsers_; open > 0;) {
+        auto item = parsed.pop();
+        if (!item) {
+            --open;
+            continue;
+        }
+        const std::size_t slot = item->sequence % maxInFlight_;
+        pending[slot] = std::move(item);
+
+        // In-flight sequences span less than one ring lap, so a filled slot at next is batch next.
+        while (pending[next % maxInFlight_]) {
+            auto& ready = pending[next % maxInFlight_];
+            if (!failed.load(std::memory_order_relaxed)) {
+                try {
+                    consume(ready->commands);
+                    commandCount += ready->commands.size();
+                } catch (...) {
+                    fail(std::current_exception());
+                }
+            }
+            ready.reset();
+            ++next;
+            credits.release();
+        }
+    }
+
+    workers.clear();
+    if (error) std::rethrow_exception(error);
+    return commandCount;
+}
+
+std::size_t Pipeline::runMerged(const std::vector<std::string>& paths, Graph& graph) {
+    Graph::Builder builder(graph, parsers_);
+    const std::size_t commands = runMerged(paths, [&builder](std::vector<Command>& batch) { builder.add(batch); });
+    builder.finish();
+    return commands;
+}
+
+/// Each file owns a ready queue of kMergeDepth parsed batches. A job (the file's number) is queued per
+/// free slot; a parser takes the file's lock, reads and parses its next batch and pushes it, so one
+/// file's batches stay in order while different files parse concurrently. The merge pops a file's
+/// next batch when its current one runs dry and queues a job to refill the slot.
+std::size_t Pipeline::runMerged(const std::vector<std::string>& paths, const Consumer& consume) {
+    struct Source {
+        History history;
+        Command::Format format = Command::Format::Bash;
+        bool detected = false;
+        bool continued = false;       // zsh: last line ended in a backslash
+        std::int64_t timestamp = 0;   // bash: time in effect at the next batch
+        std::mutex mutex;
+        BoundedQueue<std::optional<Parsed>> ready{kMergeDepth};
+
+        std::optional<Parsed> current;  // merge cursor, calling thread only
+        std::size_t next = 0;
+    };
+
+    std::vector<std::unique_ptr<Source>> sources;
+    sources.reserve(paths.size());
+    for (const auto& path : paths) {
+        auto& source = sources.emplace_back(std::make_unique<Source>());
+        source->history.setStreaming(true);
+        source->history.loadFromFile(path);
+    }
+    if (sources.empty()) return 0;
+
+    constexpr std::size_t kStop = static_cast<std::size_t>(-1);
+    const std::size_t workerCount = std::min(parsers_, sources.size());
+    const std::size_t sourceBytes = std::max(kMinMergeBatchBytes, batchBytes_ / sources.size());
+    BoundedQueue<std::size_t> jobs(sources.size() * kMergeDepth + workerCount);
+
+    std::atomic<bool> failed{false};
+    std::exception_ptr error;
+    std::mutex errorMutex;
+    auto fail = [&](std::exception_ptr e) {
+        std::lock_guard lock(errorMutex);
+        if (!error) error = std::move(e);
+        failed.store(true, std::memory_order_relaxed);
+    };
+
+    std::vector<std::jthread> workers;
+    workers.reserve(workerCount);
+    for (std::size_t i = 0; i < workerCount; ++i) {
+        workers.emplace_back([&] {
+            for (std::size_t id = jobs.pop(); id != kStop; id = jobs.pop()) {
+                Source& source = *sources[id];
+                std::lock_guard lock(source.mutex);
+                std::optional<Parsed> out;  // nullopt: file exhausted (or failed)
+                try {
+                    if (!failed.load(std::memory_order_relaxed) && source.history.readBatch(sourceBytes)) {
+                        const auto& lines = source.history.getLines();
+                        const std::size_t firstIndex = source.history.getFirstLineNumber();
+                        if (!source.detected) {
+                            source.format = Command::detectFormat(lines);
+                            source.detected = true;
+                        }
+                        out.emplace();
+                        out->data = source.history.getData();
+                        if (source.format == Command::Format::Zsh) {
+                            out->commands = Command::parseZshLines(lines, out->arena, firstIndex, source.continued);
+                        } else {
+                            out->commands = Command::parseLines(lines, out->arena, source.history.getSkippable(),
+                                                                firstIndex, 1, source.timestamp);
+                            source.timestamp = Command::findLastTimestamp(lines, source.timestamp);
+                        }
+                    }
+                } catch (...) {
+                    fail(std::current_exception());
+                    out.reset();
+                }
+                // Never blocks: a job exists only for a free slot.
+                source.ready.push(std::move(out));
+            }
+        });
+    }
+    for (std::size_t id = 0; id < sources.size(); ++id) {
+        for (std::size_t i = 0; i < kMergeDepth; ++i) jobs.push(id);
+    }
+
+    // Moves the file's cursor to its next command; false once the file is exhausted. Drained batches
+    // are retired rather than freed: merged commands still point into their arenas until flushed.
+    std::vector<Parsed> retired;
+    auto advance = [&](std::size_t id) {
+        Source& source = *sources[id];
+        while (!source.current || source.next == source.current->commands.size()) {
+            if (source.current) retired.push_back(std::move(*source.current));
+            source.current = source.ready.pop();
+            source.next = 0;
+            if (!source.current) return false;
+            jobs.push(id);
+        }
+        return true;
+    };
+
+    // Min-heap of files by the time of their next command, ties by file order.
+    auto later = [&](std::size_t a, std::size_t b) {
+        const std::int64_t ta = sources[a]->current->commands[sources[a]->next].timestamp;
+        const std::int64_t tb = sources[b]->current->commands[sources[b]->next].timestamp;
+        return ta != tb ? ta > tb : a > b;
+    };
+    std::vector<std::size_t> heads;
+    for (std::size_t id = 0; id < sources.size(); ++id) {
+        if (advance(id)) heads.push_back(id);
+    }
+    std::make_heap(heads.begin(), heads.end(), later);
+
+    std::vector<Command> merged;
+    merged.reserve(kMergeBatchCommands);
+    std::size_t commandCount = 0;
+    auto flush = [&] {
+        if (!failed.load(std::memory_order_relaxed) && !merged.empty()) {
+            try {
+                consume(merged);
+            } catch (...) {
+                fail(std::current_exception());
+            }
+        }
+        merged.clear();
+        retired.clear();
+    };
+
+    while (!heads.empty()) {
+        std::pop_heap(heads.begin(), heads.end(), later);
+        const std::size_t id = heads.back();
+        Source& source = *sources[id];
+        Command& cmd = merged.emplace_back(std::move(source.current->commands[source.next++]));
+        cmd.index = commandCount++;
+
+        if (advance(id)) {
+            std::push_heap(heads.begin(), heads.end(), later);
+        } else {
+            heads.pop_back();
+        }
+        if (merged.size() == kMergeBatchCommands) flush();
+    }
+    flush();
+
+    for (std::size_t i = 0; i < workerCount; ++i) jobs.push(kStop);
+    workers.clear();
+    if (error) std::rethrow_exception(error);
+    return commandCount;
+}
@@ -1,49 +1,61 @@
 #include "Renderer.hpp"
 
 #include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <iterator>
+#include <thread>
 
 using namespace stars;
 
-/// Draw a single star '*' and put its label to the right.
-void Renderer::drawStar(const Layout::Position& p, const std::string& label) {
-    if (p.y >= canvas.size()) return;
+namespace {
+
+struct Rgb {
+    int r, g, b;
+};
+
+/// Cold to hot: deep blue, cyan, green, yellow, red.
+Rgb heatColor(std::uint8_t heat) {
+    static constexpr Rgb kStops[] = {{40, 60, 200}, {0, 170, 255}, {60, 200, 80}, {255, 210, 0}, {255, 50, 30}};
+    constexpr int kSpans = static_cast<int>(std::size(kStops)) - 1;
+    const int position = (heat - 1) * kSpans * 256 / 254;  // 8 fractional bits along the stops.
+    const int span = std::min(position >> 8, kSpans - 1);
+    const int t = position - span * 256;
+    const Rgb& from = kStops[span];
+    const Rgb& to = kStops[span + 1];
+    return {from.r + (to.r - from.r) * t / 256, from.g + (to.g - from.g) * t / 256, from.b + (to.b - from.b) * t / 256};
+}
 
-    auto& row = canvas[p.y];
-    if (p.x >= row.size()) return;
+}  // namespace
+
+/// Draw a single star '*' and put its label to the right.
+void Renderer::drawStar(const Layout::Position& p, std::string_view label, std::uint8_t heat) {
+    if (p.y >= height_ || p.x >= width_) return;
 
     // Draw the star itself.
-    row[p.x] = '*';
+    Cell* cells = row(p.y);
+    cells[p.x] = {'*', Ink::Star, heat};
 
     // Draw label starting immediately after the star to avoid connector gaps.
-    std::size_t lx = p.x + 1;
-    for (char c : label) {
-        if (lx >= row.size()) break;
-        row[lx++] = c;
-    }
+    const std::size_t count = std::min(label.size(), width_ - p.x - 1);
+    for (std::size_t i = 0; i < count; ++i) cells[p.x + 1 + i] = {label[i], Ink::Label, heat};
 }
 
-void Renderer::drawConnector(const Layout::Position& a, const Layout::Position& b) {
-    // --- Convert positions to integer grid coordinates ---
-    const int x0 = static_cast<int>(a.x);
-    const int y0 = static_cast<int>(a.y);
-    const int x1 = static_cast<int>(b.x);
-    const int y1 = static_cast<int>(b.y);
-
-    // --- Compute deltas and the number of steps for DDA ---
-    const int dx = x1 - x0;
-    const int dy = y1 - y0;
-    const int adx = (dx >= 0) ? dx : -dx;
-    const int ady = (dy >= 0) ? dy : -dy;
-    const int steps = (adx > ady) ? adx : ady;
-
-    // If both points are the same, nothing to draw (or a single tick if desired).
-    if (steps == 0) {
-        if (y0 >= 0 && y0 < static_cast<int>(canvas.size())) {
-            auto& row = canvas[y0];
-            if (x0 >= 0 && x0 < static_cast<int>(row.size())) {
-                if (row[x0] == ' ') {
-                    row[x0] = '-';  // minimal mark for a degenerate connector
-                }
+void Renderer::drawConnector(const Segment& segment, const Rect& clip) {
+    const Layout::Position& a = segment.a;
+    const Layout::Position& b = segment.b;
+    const auto x0 = static_cast<std::int64_t>(a.x);
+    const auto y0 = static_cast<std::int64_t>(a.y);
+    const std::int64_t dx = static_cast<std::int64_t>(b.x) - x0;
+    const std::int64_t dy = static_cast<std::int64_t>(b.y) - y0;
+
+    // If both points are the same, leave a single tick.
+    if (dx == 0 && dy == 0) {
+        if (a.x >= clip.x0 && a.x < clip.x1 && a.y >= clip.y0 && a.y < clip.y1) {
+            Cell& cell = row(a.y)[a.x];
+            if (cell.glyph == ' ') {
+                cell = {'-', Ink::Connector, segment.heat};  // minimal mark for a degenerate connector
             }
         }
         return;
@@ -60,67 +72,225 @@ void Renderer::drawConnector(const Layout::Position& a, const Layout::Position&
         glyph = (dy > 0) ? '\\' : '/';
     }
 
-    // --- DDA increments per step (floating point for clarity) ---
-    const double incX = static_cast<double>(dx) / static_cast<double>(steps);
-    const double incY = static_cast<double>(dy) / static_cast<double>(steps);
-
-    // --- Iterate along the segment and plot only into empty cells ---
-    double xf = static_cast<double>(x0);
-    double yf = static_cast<double>(y0);
-
-    for (int i = 0; i <= steps; ++i) {
-        // Round to nearest integer grid cell.
-        const int xi = static_cast<int>(std::round(xf));
-        const int yi = static_cast<int>(std::round(yf));
-
-        // Bounds check per point.
-        if (yi >= 0 && yi < static_cast<int>(canvas.size())) {
-            auto& row = canvas[yi];
-            if (xi >= 0 && xi < static_cast<int>(row.size())) {
-                // Do not overwrite stars or labels: only draw into empty space.
-                if (row[xi] == ' ') {
-                    row[xi] = glyph;
-                }
-            }
+    // --- Step the major axis one cell at a time; after i steps the minor axis has moved
+    // round(i * minor / steps) cells, ties away from the origin corner as std::round does ---
+    const bool xMajor = std::abs(dx) >= std::abs(dy);
+    const std::int64_t steps = xMajor ? std::abs(dx) : std::abs(dy);
+    const std::int64_t minor = xMajor ? std::abs(dy) : std::abs(dx);
+    const std::int64_t majorSign = (xMajor ? dx : dy) > 0 ? 1 : -1;
+    const std::int64_t minorSign = (xMajor ? dy : dx) < 0 ? -1 : 1;
+    const std::int64_t m0 = xMajor ? x0 : y0;
+    const std::int64_t q0 = xMajor ? y0 : x0;
+    const auto mLo = static_cast<std::int64_t>(xMajor ? clip.x0 : clip.y0);
+    const auto mHi = static_cast<std::int64_t>(xMajor ? clip.x1 : clip.y1);
+    const auto qLo = static_cast<std::int64_t>(xMajor ? clip.y0 : clip.x0);
+    const auto qHi = static_cast<std::int64_t>(xMajor ? clip.y1 : clip.x1);
+    // Minor offset after i steps is (2 * i * minor + bias) / (2 * steps), rounded down.
+    const std::int64_t bias = minorSign > 0 ? steps : steps - 1;
+
+    // --- Clip once: the steps whose cell lies inside clip form one range [first, last] ---
+    std::int64_t first = 0;
+    std::int64_t last = steps;
+    if (majorSign > 0) {
+        first = std::max(first, mLo - m0);
+        last = std::min(last, mHi - 1 - m0);
+    } else {
+        first = std::max(first, m0 - mHi + 1);
+        last = std::min(last, m0 - mLo);
+    }
+    const std::int64_t offsetLo = minorSign > 0 ? qLo - q0 : q0 - qHi + 1;
+    const std::int64_t offsetHi = minorSign > 0 ? qHi - 1 - q0 : q0 - qLo;
+    if (offsetHi < 0) return;
+    if (minor == 0) {
+        if (offsetLo > 0) return;
+    } else {
+        last = std::min(last, (2 * steps * (offsetHi + 1) - bias - 1) / (2 * minor));
+        if (offsetLo > 0) first = std::max(first, (2 * steps * offsetLo - bias + 2 * minor - 1) / (2 * minor));
+    }
+    if (first > last) return;
+
+    // --- Plot without bounds checks, only into empty cells ---
+    const auto stride = static_cast<std::int64_t>(width_);
+    const std::int64_t majorStep = xMajor ? majorSign : majorSign * stride;
+    const std::int64_t minorStep = xMajor ? minorSign * stride : minorSign;
+    std::int64_t error = 2 * first * minor + bias;
+    const std::int64_t offset = error / (2 * steps);
+    error %= 2 * steps;
+    const std::int64_t m = m0 + majorSign * first;
+    const std::int64_t q = q0 + minorSign * offset;
+    Cell* cell = frame_.data() + (xMajor ? q * stride + m : m * stride + q);
+    for (std::int64_t i = first; i <= last; ++i) {
+        // Do not overwrite stars, labels or earlier connectors.
+        if (cell->glyph == ' ') *cell = {glyph, Ink::Connector, segment.heat};
+        cell += majorStep;
+        error += 2 * minor;
+        if (error >= 2 * steps) {
+            error -= 2 * steps;
+            cell += minorStep;
         }
+    }
+}
 
-        xf += incX;
-        yf += incY;
+void Renderer::drawSegments() {
+    const std::size_t count = segments_.size();
+    std::size_t threads = threads_ != 0 ? threads_ : std::max(1u, std::thread::hardware_concurrency());
+    threads = std::min(threads, std::max<std::size_t>(1, count / kMinEdgesPerThread));
+    if (threads == 1) {
+        const Rect canvas{0, 0, width_, height_};
+        for (const Segment& s : segments_) drawConnector(s, canvas);
+        return;
+    }
+
+    // Bin each segment into every tile its bounding box touches, keeping drawing order per tile, so
+    // a tile drawn alone resolves overlaps exactly as the whole canvas drawn in order would.
+    const std::size_t tilesX = (width_ + kTileWidth - 1) / kTileWidth;
+    const std::size_t tilesY = (height_ + kTileHeight - 1) / kTileHeight;
+    const std::size_t tiles = tilesX * tilesY;
+    auto forEachTile = [&](const Segment& s, auto&& visit) {
+        const std::size_t left = std::min(s.a.x, s.b.x);
+        const std::size_t top = std::min(s.a.y, s.b.y);
+        if (left >= width_ || top >= height_) return;
+        const std::size_t right = std::min(std::max(s.a.x, s.b.x), width_ - 1);
+        const std::size_t bottom = std::min(std::max(s.a.y, s.b.y), height_ - 1);
+        for (std::size_t ty = top / kTileHeight; ty <= bottom / kTileHeight; ++ty) {
+            for (std::size_t tx = left / kTileWidth; tx <= right / kTileWidth; ++tx) visit(ty * tilesX + tx);
+        }
+    };
+    tileOffsets_.assign(tiles + 1, 0);
+    for (const Segment& s : segments_) forEachTile(s, [&](std::size_t t) { ++tileOffsets_[t + 1]; });
+    for (std::size_t t = 0; t < tiles; ++t) tileOffsets_[t + 1] += tileOffsets_[t];
+    tileSegments_.resize(tileOffsets_[tiles]);
+    for (std::size_t i = 0; i < count; ++i) {
+        forEachTile(segments_[i], [&](std::size_t t) { tileSegments_[tileOffsets_[t]++] = static_cast<std::uint32_t>(i); });
+    }
+    for (std::size_t t = tiles; t > 0; --t) tileOffsets_[t] = tileOffsets_[t - 1];
+    tileOffsets_[0] = 0;
+
+    // Tiles own disjoint cells, so workers take them in any order without locking the frame.
+    std::atomic<std::size_t> next{0};
+    auto work = [&] {
+        for (std::size_t t = next++; t < tiles; t = next++) {
+            const std::size_t x = t % tilesX * kTileWidth;
+            const std::size_t y = t / tilesX * kTileHeight;
+            const Rect clip{x, y, std::min(x + kTileWidth, width_), std::min(y + kTileHeight, height_)};
+            for (std::uint32_t i = tileOffsets_[t]; i < tileOffsets_[t + 1]; ++i) {
+                drawConnector(segments_[tileSegments_[i]], clip);
+            }
+        }
+    };
+    {
+        std::vector<std::jthread> workers;
+        workers.reserve(threads - 1);
+        for (std::size_t t = 1; t < threads; ++t) workers.emplace_back(work);
+        work();
     }
 }
 
 /// Render graph to ASCII buffer following the layout.
+std::string_view Renderer::render(const Graph::Frozen& graph, const Layout& layout) {
+    draw(graph, layout);
+
+    // Serialize rows, each followed by a newline, into the reused output buffer. A colour escape is
+    // only written where the pen changes; spaces show no colour, so they never change it.
+    output_.clear();
+    for (std::size_t y = 0; y < height_; ++y) {
+        const Cell* cells = row(y);
+        std::uint8_t pen = 0;
+        for (std::size_t x = 0; x < width_; ++x) {
+            const Cell& cell = cells[x];
+            if (cell.heat != pen && cell.glyph != ' ') {
+                output_ += cell.heat != 0 ? getPen(cell.heat) : kResetPen;
+                pen = cell.heat;
+            }
+            output_ += cell.glyph;
+        }
+        if (pen != 0) output_ += kResetPen;
+        output_ += '\n';
+    }
+    return output_;
+}
+
 /// We draw base->variant connectors and specialization chain edges.
-std::string Renderer::render(const Graph& graph, const Layout& layout) {
-    // Prepare blank canvas.
+void Renderer::draw(const Graph::Frozen& graph, const Layout& layout) {
+    // Blank the framebuffer in place; storage only changes with the canvas size.
     auto [W, H] = layout.getCanvasSize();
-    for(std::size_t i = 0; i < H; ++i) {
-        canvas.emplace_back(std::string(W, ' '));
-    }
+    width_ = W;
+    height_ = H;
+    frame_.resize(W * H);
+    std::fill(frame_.begin(), frame_.end(), Cell{});
 
-    const auto& g = graph.getBoostGraph();
+    const std::size_t vertexCount = graph.getVertexCount();
+    const auto& positions = layout.getPositions();
+    computeHeat(graph, layout);
 
     // Draw edges: first base->variant, then variant->variant (specialization).
-    for (auto e : boost::make_iterator_range(boost::edges(g))) {
-        Graph::Vertex src = boost::source(e, g);
-        Graph::Vertex dst = boost::target(e, g);
-        Layout::Position ps = layout.getPosition(src);
-        Layout::Position pd = layout.getPosition(dst);
-        drawConnector(ps, pd);
+    // Stars of constellations the layout left out are skipped along with their edges.
+    segments_.clear();
+    for (Graph::Vertex src = 0; src < vertexCount; ++src) {
+        if (!layout.isPlaced(src)) continue;
+        for (Graph::Vertex dst : graph.getOutEdges(src)) {
+            if (layout.isPlaced(dst)) segments_.push_back({positions[src], positions[dst], heat_[dst]});
+        }
     }
+    drawSegments();
 
     // Draw vertices last to avoid line overwrite.
-    for (auto v : boost::make_iterator_range(boost::vertices(g))) {
-        Layout::Position p = layout.getPosition(v);
-        drawStar(p, g[v].label);
+    for (Graph::Vertex v = 0; v < vertexCount; ++v) {
+        if (layout.isPlaced(v)) drawStar(positions[v], graph.getLabel(v), heat_[v]);
     }
+}
+
+const std::vector<Renderer::Cell>& Renderer::getFrame() const {
+    return frame_;
+}
 
-    // Join lines.
-    std::string out;
-    out.reserve(H * (W + 1));
-    for (const auto& row : canvas) {
-        out.append(row);
-        out.push_back('\n');
+std::pair<std::size_t, std::size_t> Renderer::getCanvasSize() const {
+    return {width_, height_};
+}
+
+Renderer::Cell* Renderer::row(std::size_t y) {
+    return frame_.data() + y * width_;
+}
+
+void Renderer::computeHeat(const Graph::Frozen& graph, const Layout& layout) {
+    const std::size_t vertexCount = graph.getVertexCount();
+    heat_.assign(vertexCount, 0);
+    if (palette_ == Palette::None) return;
+
+    std::size_t hottest = 1;
+    for (Graph::Vertex v = 0; v < vertexCount; ++v) {
+        if (layout.isPlaced(v)) hottest = std::max(hottest, graph.getFrequency(v));
+    }
+    const double scale = std::log1p(static_cast<double>(hottest));
+    for (Graph::Vertex v = 0; v < vertexCount; ++v) {
+        if (!layout.isPlaced(v)) continue;
+        const double level = std::log1p(static_cast<double>(graph.getFrequency(v))) / scale;
+        heat_[v] = static_cast<std::uint8_t>(1 + std::lround(254 * std::clamp(level, 0.0, 1.0)));
+    }
+}
+
+void Renderer::setThreads(std::size_t threads) {
+    threads_ = threads;
+}
+
+void Renderer::setPalette(Palette palette) {
+    palette_ = palette;
+    pens_.assign(256, std::string());
+    if (palette == Palette::None) return;
+
+    for (int heat = 1; heat < 256; ++heat) {
+        const auto [r, g, b] = heatColor(static_cast<std::uint8_t>(heat));
+        std::string& pen = pens_[static_cast<std::size_t>(heat)];
+        if (palette == Palette::TrueColor) {
+            pen = "\x1b[38;2;" + std::to_string(r) + ";" + std::to_string(g) + ";" + std::to_string(b) + "m";
+        } else {
+            // Nearest corner of the 6x6x6 cube that starts at colour 16.
+            const int index = 16 + 36 * ((r * 5 + 127) / 255) + 6 * ((g * 5 + 127) / 255) + (b * 5 + 127) / 255;
+            pen = "\x1b[38;5;" + std::to_string(index) + "m";
+        }
     }
-    return out;
+}
+
+std::string_view Renderer::getPen(std::uint8_t heat) const {
+    return heat < pens_.size() ? std::string_view(pens_[heat]) : std::string_view();
 }
@@ -1,6 +1,10 @@
 #include "Terminal.hpp"
 
+#include <unistd.h>
+
+#include <filesystem>
 #include <iostream>
+#include <system_error>
 
 using namespace stars;
 
@@ -11,8 +15,29 @@ std::pair<std::size_t, std::size_t> Terminal::getSize() {
     return {fallbackWidth, fallbackHeight};
 }
 
-void Terminal::write(const std::string& buffer) {
-    std::cout << buffer << std::flush;
+void Terminal::write(std::string_view buffer) {
+    std::cout.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    std::cout.flush();
+}
+
+int Terminal::getColorDepth() {
+    if (!::isatty(STDOUT_FILENO)) return 0;
+    const std::string_view colorTerm = std::getenv("COLORTERM") ? std::getenv("COLORTERM") : "";
+    if (colorTerm == "truecolor" || colorTerm == "24bit") return 24;
+    const std::string_view term = std::getenv("TERM") ? std::getenv("TERM") : "";
+    return term.find("256color") != std::string_view::npos ? 8 : 0;
+}
+
+void Terminal::clear() {
+    std::cout << "\x1b[H\x1b[2J";
+}
+
+void Terminal::beginAnimation() {
+    std::cout << "\x1b[?25l" << std::flush;
+}
+
+void Terminal::endAnimation(std::size_t height) {
+    std::cout << "\x1b[0m\x1b[" << height + 1 << ";1H\x1b[?25h" << std::flush;
 }
 
 std::string Terminal::getHistoryPath() {
@@ -24,4 +49,20 @@ std::string Terminal::getHistoryPath() {
     std::string path = std::string(home) + "/.bash_history";
 
     return path;
-}
\ No newline at end of file
+}
+
+std::string Terminal::getCacheDirectory() {
+    std::filesystem::path directory;
+    if (const char* xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg) {
+        directory = std::filesystem::path(xdg) / "stars";
+    } else if (const char* home = std::getenv("HOME"); home && *home) {
+        directory = std::filesystem::path(home) / ".cache" / "stars";
+    } else {
+        return {};
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    if (error) return {};
+    return directory.string();
+}
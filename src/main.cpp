@@ -1,25 +1,66 @@
 #include <boost/program_options.hpp>
+#include <algorithm>
+#include <chrono>
+#include <csignal>
 #include <cstdlib>
+#include <ctime>
 #include <iostream>
 #include <memory>
+#include <optional>
+#include <stdexcept>
 #include <string>
+#include <thread>
+#include <vector>
 
+#include "Animator.hpp"
 #include "Configuration.hpp"
 #include "Graph.hpp"
 #include "History.hpp"
 #include "Layout.hpp"
+#include "Pipeline.hpp"
 #include "Renderer.hpp"
 #include "Terminal.hpp"
 
 using namespace stars;
 namespace po = boost::program_options;
 
+namespace {
+
+volatile std::sig_atomic_t stopRequested = 0;
+
+void requestStop(int) {
+    stopRequested = 1;
+}
+
+}  // namespace
+
 int main(int argc, char** argv) {
     po::options_description desc("stars options");
-    desc.add_options()("help,h", "Show help");
+    desc.add_options()
+        ("help,h", "Show help")
+        ("input,i", po::value<std::vector<std::string>>()->multitoken()->composing()
+                        ->default_value({"resources/.bash_history"}, "resources/.bash_history"),
+         "History files to read (bash or zsh, plain, gzip or zstd; - for stdin); several are merged by timestamp")
+        ("follow,f", "Keep watching the history file and redraw as commands are appended")
+        ("no-cache", "Ignore and do not write the graph snapshot cache")
+        ("jobs,j", po::value<std::size_t>()->default_value(0), "Worker threads for parsing, graph building, layout and drawing (0 = one per CPU)")
+        ("constellations,k", po::value<std::size_t>()->default_value(1), "Constellations to draw, most used first")
+        ("memory-budget", po::value<std::size_t>()->default_value(0),
+         "Bytes for approximate top-k selection on huge histories (0 = exact, keep every variant)")
+        ("since", po::value<std::string>(), "Only count commands from this recent window, e.g. 12h, 7d, 2w")
+        ("layout", po::value<std::string>()->default_value("packed"), "Star placement: packed or force")
+        ("layout-iterations", po::value<std::size_t>()->default_value(300), "Force layout steps at most")
+        ("layout-ms", po::value<std::size_t>()->default_value(30), "Force layout time budget per redraw")
+        ("animate", "Screensaver mode: twinkling stars, fading connectors and a slow pan until interrupted")
+        ("fps", po::value<std::size_t>()->default_value(15), "Animation frames per second (1 to 1000)")
+        ("color", po::value<std::string>()->default_value("auto"),
+         "Colour stars by use: auto, never, 256 or truecolor");
+
+    po::positional_options_description positional;
+    positional.add("input", -1);
 
     po::variables_map vm;
-    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::store(po::command_line_parser(argc, argv).options(desc).positional(positional).run(), vm);
     po::notify(vm);
 
     if (vm.count("help")) {
@@ -33,13 +74,188 @@ int main(int argc, char** argv) {
     auto renderer = std::make_unique<Renderer>();
     auto [termW, termH] = Terminal::getSize();
     auto historyPath = Terminal::getHistoryPath();
-    auto testHistoryPath = "resources/.bash_history";
-    auto constellationLimit = 1;
-
-    Configuration config(testHistoryPath, termW, termH, constellationLimit);
-    history->loadFromFile(config.getInputPath());
-    graph->build(Command::parseLines(history->getLines()));
-    layout->compute(*graph, config.getWidth(), config.getHeight(), config.getMaxConstellations());
-    Terminal::write(renderer->render(*graph, *layout));
+    const auto& inputPaths = vm["input"].as<std::vector<std::string>>();
+    auto constellationLimit = vm["constellations"].as<std::size_t>();
+
+    Configuration config(inputPaths.front(), termW, termH, constellationLimit);
+    config.setInputPaths(inputPaths);
+    config.setFollow(vm.count("follow") > 0);
+    config.setUseCache(vm.count("no-cache") == 0);
+    config.setThreads(vm["jobs"].as<std::size_t>());
+    config.setMemoryBudget(vm["memory-budget"].as<std::size_t>());
+    if (vm.count("since")) {
+        try {
+            config.setWindow(Configuration::parseDuration(vm["since"].as<std::string>()));
+        } catch (const std::invalid_argument& e) {
+            std::cerr << "stars: " << e.what() << "\n";
+            return 1;
+        }
+    }
+    const auto& layoutMode = vm["layout"].as<std::string>();
+    if (layoutMode != "packed" && layoutMode != "force") {
+        std::cerr << "stars: unknown layout: " << layoutMode << "\n";
+        return 1;
+    }
+    config.setForceLayout(layoutMode == "force");
+    config.setLayoutBudget(vm["layout-iterations"].as<std::size_t>(),
+                           std::chrono::milliseconds(vm["layout-ms"].as<std::size_t>()));
+    config.setAnimate(vm.count("animate") > 0);
+    try {
+        config.setFramesPerSecond(vm["fps"].as<std::size_t>());
+    } catch (const std::invalid_argument& e) {
+        std::cerr << "stars: " << e.what() << "\n";
+        return 1;
+    }
+    const auto& color = vm["color"].as<std::string>();
+    if (color == "auto") {
+        config.setColorDepth(Terminal::getColorDepth());
+    } else if (color == "never" || color == "256" || color == "truecolor") {
+        config.setColorDepth(color == "never" ? 0 : color == "256" ? 8 : 24);
+    } else {
+        std::cerr << "stars: unknown colour mode: " << color << "\n";
+        return 1;
+    }
+    layout->setMode(config.getForceLayout() ? Layout::Mode::Force : Layout::Mode::Packed);
+    layout->setForceBudget(config.getLayoutIterations(), config.getLayoutTime());
+    layout->setThreads(config.getThreads());
+    renderer->setThreads(config.getThreads());
+    renderer->setPalette(config.getColorDepth() == 24  ? Renderer::Palette::TrueColor
+                         : config.getColorDepth() == 8 ? Renderer::Palette::Ansi256
+                                                       : Renderer::Palette::None);
+
+    const bool merging = config.getInputPaths().size() > 1;
+    // Standard input, and pipes or FIFOs such as the /dev/fd/63 of <(zcat h.gz), are read once.
+    const bool readOnce = std::any_of(inputPaths.begin(), inputPaths.end(), History::isReadOnce);
+    if (merging && config.getFollow()) {
+        std::cerr << "stars: --follow takes a single input\n";
+        return 1;
+    }
+    if (readOnce && (config.getFollow() || config.getMemoryBudget() > 0)) {
+        // Both need to read the input again, and a pipe is read once.
+        std::cerr << "stars: --follow and --memory-budget need regular files, not standard input or pipes\n";
+        return 1;
+    }
+
+    // Startup: resume from the snapshot when the history only grew since it was written.
+    std::string cachePath;
+    // A budgeted graph only holds the top constellations, and a merged one has no single source to
+    // validate against, so neither is cached.
+    if (config.getUseCache() && config.getMemoryBudget() == 0 && !merging && !readOnce) {
+        auto cacheDirectory = Terminal::getCacheDirectory();
+        if (!cacheDirectory.empty()) {
+            cachePath = cacheDirectory + "/" + History::getCacheName(config.getInputPath()) + ".snapshot";
+        }
+    }
+    bool resumed = false;
+    history->setStreaming(true);
+    if (auto source = cachePath.empty() ? std::nullopt : graph->loadSnapshot(cachePath)) {
+        resumed = history->loadFromFile(config.getInputPath(), *source);
+        if (!resumed) graph = std::make_unique<Graph>();
+    } else if (!merging) {
+        history->loadFromFile(config.getInputPath());  // Merged files are loaded by the pipeline.
+    }
+
+    // Stream the unread lines through the parser pool straight into the graph.
+    Pipeline pipeline(config.getThreads());
+    const std::size_t budget = config.getMemoryBudget();
+    const std::size_t k = config.getMaxConstellations();
+    std::size_t folded = 0;
+    if (merging) {
+        folded = budget > 0 ? pipeline.runMergedTopK(config.getInputPaths(), *graph, k, budget)
+                            : pipeline.runMerged(config.getInputPaths(), *graph);
+    } else {
+        folded = budget > 0 ? pipeline.runTopK(*history, *graph, k, budget) : pipeline.run(*history, *graph);
+    }
+
+    auto fingerprint = history->getFingerprint();
+    if ((!resumed || folded > 0) && !cachePath.empty() && !fingerprint.path.empty()) {
+        try {
+            graph->saveSnapshot(cachePath, fingerprint);
+        } catch (const std::exception& e) {
+            std::cerr << "stars: " << e.what() << "\n";
+        }
+    }
+    // Windows are relative to the wall clock at each redraw.
+    auto windowStart = [&config]() -> std::int64_t {
+        return config.getWindow() > 0 ? static_cast<std::int64_t>(std::time(nullptr)) - config.getWindow() : 0;
+    };
+    auto relayout = [&]() {
+        auto frozen = graph->freeze(windowStart());
+        layout->compute(frozen, config.getWidth(), config.getHeight(), config.getMaxConstellations());
+        return frozen;
+    };
+    if (!config.getAnimate()) {
+        const auto frozen = relayout();
+        Terminal::write(renderer->render(frozen, *layout));
+        if (!config.getFollow()) return 0;
+    }
+
+    // Tail mode: sleep in inotify, parse only appended lines, redraw only on graph changes.
+    if (config.getFollow()) {
+        try {
+            history->follow();
+        } catch (const std::exception& e) {
+            std::cerr << "stars: " << e.what() << "\n";
+            return 1;
+        }
+    }
+    std::int64_t timestamp = pipeline.getLastTimestamp();
+    bool continued = false;
+    // A resumed run may not have read any line to detect the format from yet.
+    std::optional<Command::Format> format;
+    if (folded > 0) format = pipeline.getFormat();
+    // Fold the lines appended since the last read into the graph; whether the graph changed.
+    auto readAppended = [&]() {
+        if (history->readAppended() == 0) return false;
+
+        Command::Arena arena;
+        const auto& lines = history->getLines();
+        if (!format) format = Command::detectFormat(lines);
+        auto commands = *format == Command::Format::Zsh
+                            ? Command::parseZshLines(lines, arena, history->getFirstLineNumber(), continued)
+                            : Command::parseLines(lines, arena, history->getSkippable(),
+                                                  history->getFirstLineNumber(), 1, timestamp);
+        timestamp = Command::findLastTimestamp(lines, timestamp);
+        return !graph->append(commands).empty();
+    };
+
+    if (!config.getAnimate()) {
+        for (;;) {
+            history->waitForChange();
+            if (!readAppended()) continue;
+
+            const auto frozen = relayout();
+            Terminal::clear();
+            Terminal::write(renderer->render(frozen, *layout));
+        }
+    }
+
+    // Screensaver: hold the frame rate, and when following wait for appends between frames.
+    std::signal(SIGINT, requestStop);
+    std::signal(SIGTERM, requestStop);
+    renderer->draw(relayout(), *layout);
+    Animator animator;
+    const std::chrono::nanoseconds period = std::chrono::seconds(1) / config.getFramesPerSecond();
+    const auto start = std::chrono::steady_clock::now();
+    auto next = start;
+    Terminal::beginAnimation();
+    while (!stopRequested) {
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        Terminal::write(animator.frame(*renderer, std::chrono::duration_cast<std::chrono::milliseconds>(elapsed)));
+
+        // Running late restarts the schedule instead of bunching up catch-up frames.
+        next = std::max(next + period, std::chrono::steady_clock::now());
+        if (config.getFollow()) {
+            // Stop at the deadline even if changes keep arriving, or a ready watch would starve the frames.
+            for (auto now = std::chrono::steady_clock::now(); !stopRequested && now < next;
+                 now = std::chrono::steady_clock::now()) {
+                if (!history->waitForChange(std::chrono::ceil<std::chrono::milliseconds>(next - now))) break;
+                if (readAppended()) renderer->draw(relayout(), *layout);
+            }
+        } else {
+            std::this_thread::sleep_until(next);
+        }
+    }
+    Terminal::endAnimation(renderer->getCanvasSize().second);
     return 0;
 }
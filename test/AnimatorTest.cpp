@@ -0,0 +1,146 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Animator.hpp"
+#include "Command.hpp"
+#include "Graph.hpp"
+#include "Layout.hpp"
+#include "Renderer.hpp"
+
+using namespace stars;
+
+namespace {
+
+/// Just enough of a VT100 to replay frames: home, clear, cursor position, cursor forward, colour, text.
+class Screen {
+   public:
+    Screen(std::size_t width, std::size_t height)
+        : width_(width), cells_(width * height, '?'), pens_(width * height) {}
+
+    void apply(std::string_view bytes) {
+        for (std::size_t i = 0; i < bytes.size();) {
+            if (bytes[i] != '\x1b') {
+                ASSERT_LT(x_, width_) << "wrote past the end of a row";
+                cells_[y_ * width_ + x_] = bytes[i++];
+                pens_[y_ * width_ + x_++] = pen_;
+                continue;
+            }
+            ASSERT_EQ(bytes[i + 1], '[');
+            std::size_t end = i + 2;
+            while (bytes[end] == ';' || (bytes[end] >= '0' && bytes[end] <= '9')) ++end;
+            const std::string parameters(bytes.substr(i + 2, end - i - 2));
+            const std::size_t separator = parameters.find(';');
+            switch (bytes[end]) {
+                case 'H':
+                    y_ = parameters.empty() ? 0 : std::stoul(parameters.substr(0, separator)) - 1;
+                    x_ = parameters.empty() ? 0 : std::stoul(parameters.substr(separator + 1)) - 1;
+                    break;
+                case 'J':
+                    std::fill(cells_.begin(), cells_.end(), ' ');
+                    std::fill(pens_.begin(), pens_.end(), std::string());
+                    break;
+                case 'C':
+                    x_ += std::stoul(parameters);
+                    break;
+                case 'm':
+                    pen_ = parameters == "0" ? std::string() : std::string(bytes.substr(i, end + 1 - i));
+                    break;
+                default:
+                    ADD_FAILURE() << "unexpected escape " << bytes[end];
+            }
+            i = end + 1;
+        }
+    }
+
+    /// First cell that differs from what the animator believes the screen shows; empty if none.
+    std::string mismatch(const Animator& animator, const Renderer& scene) const {
+        const auto& expected = animator.getScreen();
+        for (std::size_t i = 0; i < cells_.size(); ++i) {
+            const bool pensDiffer = cells_[i] != ' ' && pens_[i] != scene.getPen(expected[i].heat);
+            if (cells_[i] != expected[i].glyph || pensDiffer) return "cell " + std::to_string(i);
+        }
+        return {};
+    }
+
+   private:
+    std::size_t width_;
+    std::size_t x_ = 0;
+    std::size_t y_ = 0;
+    std::string pen_;
+    std::vector<char> cells_;
+    std::vector<std::string> pens_;
+};
+
+std::size_t countChanges(const std::vector<Renderer::Cell>& before, const std::vector<Renderer::Cell>& after) {
+    std::size_t changed = 0;
+    for (std::size_t i = 0; i < before.size(); ++i) {
+        changed += before[i].glyph != after[i].glyph || before[i].heat != after[i].heat;
+    }
+    return changed;
+}
+
+}  // namespace
+
+TEST(AnimatorTest, FramesReplayOntoTheScreenAndOnlyCarryChanges) {
+    Command::Arena arena;
+    Graph graph;
+    graph.build(Command::parseLines(
+        {"ls -l", "ls -a", "ls -l -a", "git log", "git log --oneline", "git status", "make -j", "make"}, arena));
+    const Graph::Frozen frozen = graph.freeze();
+
+    constexpr std::size_t kWidth = 90;
+    constexpr std::size_t kHeight = 24;
+    Layout layout;
+    layout.compute(frozen, kWidth, kHeight, 3);
+    Renderer renderer;
+    renderer.setPalette(Renderer::Palette::TrueColor);
+    renderer.draw(frozen, layout);
+
+    Animator animator;
+    Screen screen(kWidth, kHeight);
+    const std::string_view first = animator.frame(renderer, std::chrono::milliseconds(0));
+    ASSERT_EQ(first.substr(0, 7), "\x1b[H\x1b[2J");
+    screen.apply(first);
+    EXPECT_EQ(screen.mismatch(animator, renderer), "");
+    // Before any pan or fade, the screen shows the scene apart from twinkling stars.
+    const auto& cells = renderer.getFrame();
+    for (std::size_t i = 0; i < cells.size(); ++i) {
+        if (cells[i].ink != Renderer::Ink::Star) {
+            EXPECT_EQ(animator.getScreen()[i].glyph, cells[i].glyph);
+        }
+    }
+
+    // Nothing moves within the same millisecond.
+    EXPECT_TRUE(animator.frame(renderer, std::chrono::milliseconds(0)).empty());
+
+    // A minute at 25 fps: every frame replays exactly, and costs at most a cursor move, a colour and
+    // a glyph per changed cell.
+    const std::size_t maxCellBytes = 9 + renderer.getPen(255).size();
+    std::vector<Renderer::Cell> before = animator.getScreen();
+    std::size_t total = 0;
+    for (int millis = 40; millis <= 60000; millis += 40) {
+        const std::string_view bytes = animator.frame(renderer, std::chrono::milliseconds(millis));
+        screen.apply(bytes);
+        ASSERT_EQ(screen.mismatch(animator, renderer), "") << "at " << millis << " ms";
+
+        const std::size_t changed = countChanges(before, animator.getScreen());
+        if (changed == 0) {
+            EXPECT_TRUE(bytes.empty());
+        }
+        EXPECT_LE(bytes.size(), changed * maxCellBytes + Renderer::kResetPen.size()) << "at " << millis << " ms";
+        before = animator.getScreen();
+        total += bytes.size();
+    }
+    EXPECT_LT(total, 1500 * kWidth * kHeight / 5);
+
+    // A new size repaints from a cleared screen.
+    layout.compute(frozen, kWidth - 10, kHeight, 3);
+    renderer.draw(frozen, layout);
+    EXPECT_EQ(animator.frame(renderer, std::chrono::milliseconds(60040)).substr(0, 7), "\x1b[H\x1b[2J");
+}
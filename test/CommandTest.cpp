@@ -0,0 +1,176 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Command.hpp"
+
+using namespace stars;
+
+namespace {
+
+bool pointsInto(std::string_view token, std::string_view line) {
+    return token.data() >= line.data() && token.data() + token.size() <= line.data() + line.size();
+}
+
+}  // namespace
+
+TEST(CommandTest, ClassifiesBaseFlagsAndArgs) {
+    const std::vector<std::string_view> lines{"ls   -t  dir -a", "", "# note", "  git log --oneline"};
+    Command::Arena arena;
+    auto commands = Command::parseLines(lines, arena);
+
+    ASSERT_EQ(commands.size(), 2u);
+    EXPECT_EQ(commands[0].base, "ls");
+    ASSERT_EQ(commands[0].flags.size(), 2u);
+    EXPECT_EQ(commands[0].flags[0], "-a");
+    EXPECT_EQ(commands[0].flags[1], "-t");
+    ASSERT_EQ(commands[0].args.size(), 1u);
+    EXPECT_EQ(commands[0].args[0], "dir");
+    EXPECT_EQ(commands[0].index, 0u);
+
+    EXPECT_EQ(commands[1].base, "git");
+    ASSERT_EQ(commands[1].args.size(), 1u);
+    EXPECT_EQ(commands[1].args[0], "log");
+    ASSERT_EQ(commands[1].flags.size(), 1u);
+    EXPECT_EQ(commands[1].flags[0], "--oneline");
+    EXPECT_EQ(commands[1].index, 3u);
+}
+
+TEST(CommandTest, PlainTokensAreViewsIntoTheLine) {
+    const std::vector<std::string_view> lines{"grep -rn TODO src"};
+    Command::Arena arena;
+    auto commands = Command::parseLines(lines, arena);
+
+    ASSERT_EQ(commands.size(), 1u);
+    EXPECT_TRUE(pointsInto(commands[0].base, lines[0]));
+    EXPECT_TRUE(pointsInto(commands[0].flags[0], lines[0]));
+    EXPECT_TRUE(pointsInto(commands[0].args[0], lines[0]));
+    EXPECT_TRUE(pointsInto(commands[0].args[1], lines[0]));
+}
+
+TEST(CommandTest, ResolvesQuotesAndEscapes) {
+    const std::vector<std::string_view> lines{
+        R"(echo "hello world" 'it''s' a\ b --fmt="%h \"x\"" "unterminated)"};
+    Command::Arena arena;
+    auto commands = Command::parseLines(lines, arena);
+
+    ASSERT_EQ(commands.size(), 1u);
+    const auto& cmd = commands[0];
+    EXPECT_EQ(cmd.base, "echo");
+    ASSERT_EQ(cmd.args.size(), 4u);
+    EXPECT_EQ(cmd.args[0], "hello world");
+    EXPECT_EQ(cmd.args[1], "its");
+    EXPECT_EQ(cmd.args[2], "a b");
+    EXPECT_EQ(cmd.args[3], "unterminated");
+    ASSERT_EQ(cmd.flags.size(), 1u);
+    EXPECT_EQ(cmd.flags[0], R"(--fmt=%h "x")");
+    EXPECT_FALSE(pointsInto(cmd.args[0], lines[0]));
+}
+
+TEST(CommandTest, ParallelParseMatchesSerial) {
+    std::vector<std::string> storage;
+    for (int i = 0; i < 100000; ++i) {
+        switch (i % 5) {
+            case 0: storage.push_back("ls -l -a dir" + std::to_string(i)); break;
+            case 1: storage.push_back("# " + std::to_string(i)); break;
+            case 2: storage.push_back("echo \"quoted " + std::to_string(i) + "\" -n"); break;
+            case 3: storage.push_back(""); break;
+            default: storage.push_back("git commit -m 'msg " + std::to_string(i) + "'"); break;
+        }
+    }
+    const std::vector<std::string_view> lines(storage.begin(), storage.end());
+
+    Command::Arena serialArena;
+    Command::Arena parallelArena;
+    const auto serial = Command::parseLines(lines, serialArena, {}, 10);
+    const auto parallel = Command::parseLines(lines, parallelArena, {}, 10, 4);
+
+    ASSERT_EQ(parallel.size(), serial.size());
+    for (std::size_t i = 0; i < serial.size(); ++i) {
+        EXPECT_EQ(parallel[i].index, serial[i].index);
+        EXPECT_EQ(parallel[i].original.data(), serial[i].original.data());
+        EXPECT_EQ(parallel[i].base, serial[i].base);
+        EXPECT_TRUE(std::equal(parallel[i].flags.begin(), parallel[i].flags.end(), serial[i].flags.begin(),
+                               serial[i].flags.end()));
+        EXPECT_TRUE(std::equal(parallel[i].args.begin(), parallel[i].args.end(), serial[i].args.begin(),
+                               serial[i].args.end()));
+    }
+}
+
+TEST(CommandTest, EpochLinesStampFollowingCommandsAcrossChunks) {
+    std::vector<std::string> storage;
+    for (int i = 0; i < 60000; ++i) {
+        if (i % 1000 == 0) storage.push_back("#" + std::to_string(1700000000 + i));
+        storage.push_back("ls -l");
+    }
+    storage.push_back("#not-a-time");
+    storage.push_back("make");
+    const std::vector<std::string_view> lines(storage.begin(), storage.end());
+
+    std::int64_t time = 0;
+    EXPECT_TRUE(Command::parseTimestamp("#1700000000", time));
+    EXPECT_EQ(time, 1700000000);
+    EXPECT_FALSE(Command::parseTimestamp("# 1700000000", time));
+    EXPECT_FALSE(Command::parseTimestamp("#", time));
+    EXPECT_FALSE(Command::parseTimestamp("#-1700000000", time));
+    EXPECT_TRUE(Command::parseTimestamp("#9223372036854775807", time));
+    EXPECT_EQ(time, INT64_MAX);
+    // 19 digits past INT64_MAX must not wrap into a bogus time.
+    EXPECT_FALSE(Command::parseTimestamp("#9999999999999999999", time));
+    EXPECT_EQ(time, INT64_MAX);
+    EXPECT_EQ(Command::findLastTimestamp(lines, 0), 1700059000);
+
+    Command::Arena serialArena;
+    Command::Arena parallelArena;
+    const auto serial = Command::parseLines(lines, serialArena, {}, 0, 1, 42);
+    const auto parallel = Command::parseLines(lines, parallelArena, {}, 0, 4, 42);
+
+    ASSERT_EQ(parallel.size(), serial.size());
+    for (std::size_t i = 0; i < serial.size(); ++i) EXPECT_EQ(parallel[i].timestamp, serial[i].timestamp);
+    EXPECT_EQ(serial.front().timestamp, 1700000000);
+    EXPECT_EQ(serial[1500].timestamp, 1700001000);
+    // A comment that is not an epoch line keeps the previous time.
+    EXPECT_EQ(serial.back().timestamp, 1700059000);
+}
+
+TEST(CommandTest, ZshEntriesKeepTheirTimeAndSkipContinuations) {
+    const std::vector<std::string_view> lines = {
+        ": 1700000000:0;git status",
+        ": 1700000005:2;for f in *; do\\",
+        "  echo $f\\",
+        "done",
+        "ls -l",  // Written before EXTENDED_HISTORY: untimed.
+        ": 1700000009:0;make -j",
+        ": 1700000010:0;echo tail\\",
+    };
+    EXPECT_EQ(Command::detectFormat(lines), Command::Format::Zsh);
+    EXPECT_EQ(Command::detectFormat({"", "#1700000000", "ls"}), Command::Format::Bash);
+
+    std::int64_t time = 0;
+    std::string_view text;
+    EXPECT_FALSE(Command::parseZshEntry(": 9999999999999999999:0;ls", time, text));
+    EXPECT_FALSE(Command::parseZshEntry(": -5:0;ls", time, text));
+
+    Command::Arena arena;
+    bool continued = false;
+    const auto commands = Command::parseZshLines(lines, arena, 100, continued);
+    ASSERT_EQ(commands.size(), 5u);
+    EXPECT_EQ(commands[0].base, "git");
+    EXPECT_EQ(commands[0].timestamp, 1700000000);
+    EXPECT_EQ(commands[1].base, "for");
+    EXPECT_EQ(commands[2].original, "ls -l");
+    EXPECT_EQ(commands[2].timestamp, 0);
+    EXPECT_EQ(commands[2].index, 104u);
+    EXPECT_EQ(commands[3].flags.front(), "-j");
+    EXPECT_TRUE(continued);
+
+    // The next batch starts inside the unfinished entry.
+    const auto next = Command::parseZshLines({"more", ": 1700000020:0;pwd"}, arena, 107, continued);
+    ASSERT_EQ(next.size(), 1u);
+    EXPECT_EQ(next[0].base, "pwd");
+    EXPECT_FALSE(continued);
+}
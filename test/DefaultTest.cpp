@@ -29,7 +29,9 @@ TEST(MainTest, RunStars) {
 
     Configuration config(testHistoryPath, termW, termH, constellationLimit);
     history->loadFromFile(config.getInputPath());
-    graph->build(Command::parseLines(history->getLines()));
-    layout->compute(*graph, config.getWidth(), config.getHeight(), config.getMaxConstellations());
-    Terminal::write(renderer->render(*graph, *layout));
+    Command::Arena arena;
+    graph->build(Command::parseLines(history->getLines(), arena, history->getSkippable()));
+    const auto frozen = graph->freeze();
+    layout->compute(frozen, config.getWidth(), config.getHeight(), config.getMaxConstellations());
+    Terminal::write(renderer->render(frozen, *layout));
 }
@@ -0,0 +1,332 @@
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <random>
+#include <set>
+#include <utility>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Command.hpp"
+#include "Graph.hpp"
+
+using namespace stars;
+
+namespace {
+
+Graph buildFrom(const std::vector<std::string_view>& lines, Command::Arena& arena) {
+    Graph graph;
+    graph.build(Command::parseLines(lines, arena));
+    return graph;
+}
+
+/// Label-keyed view of a graph: star properties and edges, independent of vertex numbering.
+std::set<std::string> describe(const Graph& graph) {
+    const auto& g = graph.getBoostGraph();
+    std::set<std::string> out;
+    for (auto v : boost::make_iterator_range(boost::vertices(g))) {
+        out.insert(graph.getLabel(v) + " x" + std::to_string(g[v].frequency) + " @" +
+                   std::to_string(g[v].firstSeenIndex));
+    }
+    for (auto e : boost::make_iterator_range(boost::edges(g))) {
+        out.insert(graph.getLabel(boost::source(e, g)) + "->" + graph.getLabel(boost::target(e, g)));
+    }
+    return out;
+}
+
+std::vector<std::string> labelsOf(const Graph& graph, const std::vector<Graph::Vertex>& vertices) {
+    std::vector<std::string> out;
+    for (auto v : vertices) out.push_back(graph.getLabel(v));
+    return out;
+}
+
+}  // namespace
+
+TEST(GraphTest, InternsVariantsAndBuildsLabels) {
+    Command::Arena arena;
+    Graph graph = buildFrom({"ls -l", "ls -a -l", "ls -l", "git log", "ls -l -a"}, arena);
+
+    const auto bases = graph.getBaseVertices();
+    ASSERT_EQ(labelsOf(graph, bases), (std::vector<std::string>{"<ls>", "<git>"}));
+
+    const auto lsVariants = graph.getVariantsForBase(bases[0]);
+    ASSERT_EQ(labelsOf(graph, lsVariants), (std::vector<std::string>{"<ls -l>", "<ls -a -l>"}));
+
+    const auto& g = graph.getBoostGraph();
+    EXPECT_EQ(g[lsVariants[0]].frequency, 2u);
+    EXPECT_EQ(g[lsVariants[1]].frequency, 2u);
+    EXPECT_EQ(graph.getSymbol(g[bases[0]].base), "ls");
+}
+
+TEST(GraphTest, ChainsToNextChronologicalSuperset) {
+    Command::Arena arena;
+    Graph graph = buildFrom({"ls -l", "ls -a", "ls -l -r", "ls -a -l -r", "ls -l -t"}, arena);
+
+    const auto& g = graph.getBoostGraph();
+    std::vector<std::string> chain;
+    for (auto e : boost::make_iterator_range(boost::edges(g))) {
+        auto src = boost::source(e, g);
+        if (g[src].isBase) continue;
+        chain.push_back(graph.getLabel(src) + "->" + graph.getLabel(boost::target(e, g)));
+    }
+    std::sort(chain.begin(), chain.end());
+
+    EXPECT_EQ(chain, (std::vector<std::string>{"<ls -a>-><ls -a -l -r>",
+                                               "<ls -l -r>-><ls -a -l -r>",
+                                               "<ls -l>-><ls -l -r>"}));
+}
+
+TEST(GraphTest, LatticeChainsMatchBruteForce) {
+    // Differential check of the posting-list index against the original pairwise scan.
+    std::mt19937 rng(42);
+    std::vector<std::string> storage;
+    for (int i = 0; i < 3000; ++i) {
+        std::string line = (i % 3 == 0) ? "git" : (i % 3 == 1) ? "docker" : "ls";
+        const int flagCount = static_cast<int>(rng() % 5);
+        for (int f = 0; f < flagCount; ++f) line += " -" + std::to_string(rng() % (i % 3 == 0 ? 100 : 8));
+        storage.push_back(line);
+    }
+    std::vector<std::string_view> lines(storage.begin(), storage.end());
+
+    Command::Arena arena;
+    Graph graph = buildFrom(lines, arena);
+    const auto& g = graph.getBoostGraph();
+
+    std::set<std::pair<Graph::Vertex, Graph::Vertex>> expected;
+    for (auto base : graph.getBaseVertices()) {
+        std::vector<Graph::Vertex> byTime = graph.getVariantsForBase(base);
+        std::sort(byTime.begin(), byTime.end(),
+                  [&](auto a, auto b) { return g[a].firstSeenIndex < g[b].firstSeenIndex; });
+        for (std::size_t i = 0; i < byTime.size(); ++i) {
+            for (std::size_t j = i + 1; j < byTime.size(); ++j) {
+                const auto& a = g[byTime[i]];
+                const auto& b = g[byTime[j]];
+                if (a.flagCount < b.flagCount && a.flags.isSubsetOf(b.flags)) {
+                    expected.emplace(byTime[i], byTime[j]);
+                    break;
+                }
+            }
+        }
+    }
+
+    std::set<std::pair<Graph::Vertex, Graph::Vertex>> actual;
+    for (auto e : boost::make_iterator_range(boost::edges(g))) {
+        if (g[boost::source(e, g)].isBase) continue;
+        actual.emplace(boost::source(e, g), boost::target(e, g));
+    }
+
+    EXPECT_FALSE(expected.empty());
+    EXPECT_EQ(actual, expected);
+}
+
+TEST(GraphTest, AppendMatchesFullBuild) {
+    std::mt19937 rng(7);
+    std::vector<std::string> storage;
+    for (int i = 0; i < 2000; ++i) {
+        std::string line = (rng() % 2) ? "git" : "ls";
+        if (rng() % 50 == 0) line = "tool" + std::to_string(i);
+        const int flagCount = static_cast<int>(rng() % 4);
+        for (int f = 0; f < flagCount; ++f) line += " -" + std::to_string(rng() % 12);
+        storage.push_back(line);
+    }
+    std::vector<std::string_view> lines(storage.begin(), storage.end());
+
+    Command::Arena arena;
+    const auto commands = Command::parseLines(lines, arena);
+
+    Graph full;
+    full.build(commands);
+
+    Graph incremental;
+    const std::size_t split = commands.size() * 3 / 4;
+    incremental.build(std::vector<Command>(commands.begin(), commands.begin() + static_cast<std::ptrdiff_t>(split)));
+    for (std::size_t i = split; i < commands.size(); i += 37) {
+        const std::size_t end = std::min(commands.size(), i + 37);
+        const auto changed = incremental.append(
+            std::vector<Command>(commands.begin() + static_cast<std::ptrdiff_t>(i),
+                                 commands.begin() + static_cast<std::ptrdiff_t>(end)));
+        EXPECT_FALSE(changed.empty());
+        EXPECT_TRUE(std::is_sorted(changed.begin(), changed.end()));
+    }
+
+    EXPECT_EQ(describe(incremental), describe(full));
+
+    // Older commands arriving late force a whole-base relink; the result must not change.
+    Graph outOfOrder;
+    outOfOrder.build(std::vector<Command>(commands.begin() + static_cast<std::ptrdiff_t>(split), commands.end()));
+    outOfOrder.append(std::vector<Command>(commands.begin(), commands.begin() + static_cast<std::ptrdiff_t>(split)));
+    EXPECT_EQ(describe(outOfOrder), describe(full));
+}
+
+TEST(GraphTest, AppendReportsOnlyTouchedStars) {
+    Command::Arena arena;
+    const std::vector<std::string_view> lines{"ls -l", "git --version", "ls -l -a", "ls -r"};
+    auto commands = Command::parseLines(lines, arena);
+
+    Graph graph;
+    graph.build(std::vector<Command>(commands.begin(), commands.begin() + 3));
+    const auto changed = graph.append(std::vector<Command>(commands.begin() + 3, commands.end()));
+
+    // Only the new "<ls -r>" star is reported: no existing variant is a subset of {-r}.
+    ASSERT_EQ(changed.size(), 1u);
+    EXPECT_EQ(graph.getLabel(changed[0]), "<ls -r>");
+
+    // Re-running an old command reorders nothing; only its frequency changes.
+    const auto again = graph.append(std::vector<Command>(commands.begin() + 1, commands.begin() + 2));
+    ASSERT_EQ(again.size(), 1u);
+    EXPECT_EQ(graph.getLabel(again[0]), "<git --version>");
+}
+
+TEST(GraphTest, SnapshotRoundTripsAndKeepsAppending) {
+    Command::Arena arena;
+    const std::vector<std::string_view> lines{"ls -l", "git commit -m", "ls -l -a", "git commit -a -m", "ls -l"};
+    auto commands = Command::parseLines(lines, arena);
+
+    Graph full;
+    full.build(commands);
+
+    Graph saved;
+    saved.build(std::vector<Command>(commands.begin(), commands.begin() + 3));
+    History::Fingerprint source;
+    source.path = "history";
+    source.size = 42;
+    source.lineCount = 3;
+    source.endsWithNewline = true;
+
+    const auto path = std::filesystem::temp_directory_path() / ("stars-snapshot-" + std::to_string(::getpid()));
+    saved.saveSnapshot(path.string(), source);
+
+    Graph loaded;
+    const auto fingerprint = loaded.loadSnapshot(path.string());
+    ASSERT_TRUE(fingerprint.has_value());
+    EXPECT_EQ(fingerprint->path, "history");
+    EXPECT_EQ(fingerprint->lineCount, 3u);
+    EXPECT_EQ(describe(loaded), describe(saved));
+
+    loaded.append(std::vector<Command>(commands.begin() + 3, commands.end()));
+    EXPECT_EQ(describe(loaded), describe(full));
+
+    // Anything that is not a snapshot of this version is rejected, leaving the graph usable.
+    std::filesystem::resize_file(path, 16);
+    EXPECT_FALSE(loaded.loadSnapshot(path.string()).has_value());
+    EXPECT_FALSE(Graph().loadSnapshot(path.string() + ".missing").has_value());
+    std::filesystem::remove(path);
+}
+
+TEST(GraphTest, ShardedBuildMatchesSerialNumbering) {
+    std::mt19937 rng(11);
+    std::vector<std::string> storage;
+    for (int i = 0; i < 140000; ++i) {
+        std::string line = "cmd" + std::to_string(rng() % 40);
+        const int flagCount = static_cast<int>(rng() % 4);
+        for (int f = 0; f < flagCount; ++f) line += " -" + std::to_string(rng() % 20);
+        storage.push_back(line);
+    }
+    std::vector<std::string_view> lines(storage.begin(), storage.end());
+    Command::Arena arena;
+    const auto commands = Command::parseLines(lines, arena);
+
+    Graph serial;
+    serial.build(commands);
+    Graph sharded;
+    sharded.build(commands, 4);
+
+    // Same vertex ids, symbols, properties and out-edge order, not just the same shape.
+    const auto& a = serial.getBoostGraph();
+    const auto& b = sharded.getBoostGraph();
+    ASSERT_EQ(boost::num_vertices(b), boost::num_vertices(a));
+    for (auto v : boost::make_iterator_range(boost::vertices(a))) {
+        EXPECT_EQ(sharded.getLabel(v), serial.getLabel(v));
+        EXPECT_EQ(b[v].base, a[v].base);
+        EXPECT_EQ(b[v].frequency, a[v].frequency);
+        EXPECT_EQ(b[v].firstSeenIndex, a[v].firstSeenIndex);
+        std::vector<Graph::Vertex> outA;
+        std::vector<Graph::Vertex> outB;
+        for (auto e : boost::make_iterator_range(boost::out_edges(v, a))) outA.push_back(boost::target(e, a));
+        for (auto e : boost::make_iterator_range(boost::out_edges(v, b))) outB.push_back(boost::target(e, b));
+        EXPECT_EQ(outB, outA);
+    }
+    ASSERT_EQ(sharded.getBaseVertices(), serial.getBaseVertices());
+    for (auto base : serial.getBaseVertices()) {
+        EXPECT_EQ(sharded.getVariantsForBase(base), serial.getVariantsForBase(base));
+    }
+
+    // The merged indexes keep working for incremental appends.
+    const std::vector<std::string_view> more{"cmd3 -1 -2 -3 -4", "newcmd -x"};
+    const auto tail = Command::parseLines(more, arena, {}, lines.size());
+    serial.append(tail);
+    sharded.append(tail);
+    EXPECT_EQ(describe(sharded), describe(serial));
+}
+
+TEST(GraphTest, FreezeKeepsNumberingEdgesAndLabels) {
+    Command::Arena arena;
+    Graph graph = buildFrom({"ls -l", "git commit -m", "ls -l -a", "git commit -a -m", "ls -l", "make"}, arena);
+    const Graph::Frozen frozen = graph.freeze();
+
+    const auto& g = graph.getBoostGraph();
+    ASSERT_EQ(frozen.getVertexCount(), boost::num_vertices(g));
+    EXPECT_EQ(frozen.getEdgeCount(), boost::num_edges(g));
+    for (auto v : boost::make_iterator_range(boost::vertices(g))) {
+        EXPECT_EQ(frozen.getLabel(v), graph.getLabel(v));
+        EXPECT_EQ(frozen.isBase(v), g[v].isBase);
+        EXPECT_EQ(frozen.getFlagCount(v), g[v].flagCount);
+        if (!g[v].isBase) {
+            EXPECT_EQ(frozen.getFrequency(v), g[v].frequency);
+        }
+
+        std::vector<Graph::Vertex> targets;
+        for (auto e : boost::make_iterator_range(boost::out_edges(v, g))) targets.push_back(boost::target(e, g));
+        const auto out = frozen.getOutEdges(v);
+        EXPECT_EQ(std::vector<Graph::Vertex>(out.begin(), out.end()), targets);
+    }
+
+    const auto bases = frozen.getBaseVertices();
+    ASSERT_EQ(std::vector<Graph::Vertex>(bases.begin(), bases.end()), graph.getBaseVertices());
+    for (auto base : bases) {
+        const auto variants = frozen.getVariantsForBase(base);
+        EXPECT_EQ(std::vector<Graph::Vertex>(variants.begin(), variants.end()), graph.getVariantsForBase(base));
+    }
+
+    // Bases carry the total of their variants: "ls" ran three times, "git" twice, "make" once.
+    EXPECT_EQ(frozen.getFrequency(bases[0]), 3u);
+    EXPECT_EQ(frozen.getFrequency(bases[1]), 2u);
+    EXPECT_EQ(frozen.getFrequency(bases[2]), 1u);
+}
+
+TEST(GraphTest, WindowedFreezeCountsOnlyRecentUses) {
+    constexpr std::int64_t kNow = 1700000000;
+    constexpr std::int64_t kDay = 86400;
+    Command::Arena arena;
+    auto commands = Command::parseLines({"ls -l", "ls -l", "git status", "ls -l", "make"}, arena);
+    commands[0].timestamp = kNow - 30 * kDay;
+    commands[1].timestamp = kNow - 2 * kDay;
+    commands[2].timestamp = kNow - 40 * kDay;
+    commands[3].timestamp = kNow - 3600;
+    // "make" has no timestamp: counted in full history only.
+
+    Graph graph;
+    graph.build(commands);
+    EXPECT_EQ(graph.getLatestTime(), kNow - 3600);
+
+    const auto all = graph.freeze();
+    EXPECT_EQ(all.getVertexCount(), boost::num_vertices(graph.getBoostGraph()));
+
+    const auto week = graph.freeze(kNow - 7 * kDay);
+    const auto bases = week.getBaseVertices();
+    ASSERT_EQ(bases.size(), 1u);
+    EXPECT_EQ(week.getLabel(bases[0]), "<ls>");
+    EXPECT_EQ(week.getFrequency(bases[0]), 2u);
+
+    Graph::Activity activity;
+    activity.add(kNow - 14 * kDay);
+    activity.add(kNow);
+    EXPECT_EQ(activity.countSince(kNow - 1), 1u);
+    EXPECT_EQ(activity.countSince(kNow - 20 * kDay), 2u);
+    EXPECT_NEAR(activity.heatAt(kNow), 1.25, 1e-9);
+    EXPECT_NEAR(activity.heatAt(kNow + 7 * kDay), 0.625, 1e-9);
+}
@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+
+#include <map>
+#include <random>
+#include <string>
+
+#include "HeavyHitters.hpp"
+
+using namespace stars;
+
+TEST(HeavyHittersTest, CountsExactlyWithinBudget) {
+    HeavyHitters sketch(1 << 20);
+    for (int i = 0; i < 5; ++i) sketch.offer("ls");
+    for (int i = 0; i < 3; ++i) sketch.offer("git");
+    sketch.offer("make");
+
+    const auto top = sketch.getTop(2);
+    ASSERT_EQ(top.size(), 2u);
+    EXPECT_EQ(top[0].key, "ls");
+    EXPECT_EQ(top[0].count, 5u);
+    EXPECT_EQ(top[0].error, 0u);
+    EXPECT_EQ(top[1].key, "git");
+    EXPECT_EQ(sketch.getTotal(), 9u);
+    EXPECT_EQ(sketch.getMaxError(), 0u);
+}
+
+TEST(HeavyHittersTest, KeepsHeavyKeysWithBoundedErrorUnderPressure) {
+    // Zipf-like stream: a few heavy keys and a long tail of one-offs, far more than fit.
+    std::mt19937 rng(5);
+    std::map<std::string, std::uint64_t> truth;
+    HeavyHitters sketch(4096);
+    for (int i = 0; i < 50000; ++i) {
+        std::string key = (rng() % 2) ? "heavy" + std::to_string(rng() % 4) : "tail" + std::to_string(i);
+        ++truth[key];
+        sketch.offer(key);
+    }
+
+    const auto bound = sketch.getMaxError();
+    for (const auto& entry : sketch.getTop(1000)) {
+        const std::uint64_t actual = truth[std::string(entry.key)];
+        EXPECT_LE(actual, entry.count);
+        EXPECT_GE(actual, entry.count - entry.error);
+    }
+    for (const auto& [key, count] : truth) {
+        if (count > bound) {
+            EXPECT_TRUE(sketch.contains(key)) << key;
+        }
+    }
+
+    const auto top = sketch.getTop(4);
+    ASSERT_EQ(top.size(), 4u);
+    for (const auto& entry : top) EXPECT_EQ(entry.key.substr(0, 5), "heavy");
+}
+
+TEST(HeavyHittersTest, BoundsHoldWhenLongKeysEvictSeveralCounters) {
+    // On 64-bit targets this fits two one-byte keys, or one of 114 bytes that evicts them both.
+    HeavyHitters sketch(226);
+    std::map<std::string, std::uint64_t> truth;
+    auto offer = [&](const std::string& key) {
+        ++truth[key];
+        sketch.offer(key);
+    };
+    for (int i = 0; i < 10; ++i) offer("a");
+    offer("b");
+    offer(std::string(114, 'x'));
+    offer("a");
+    const auto top = sketch.getTop(1);
+    ASSERT_EQ(top.size(), 1u);
+    EXPECT_EQ(top[0].key, "a");
+    EXPECT_GE(top[0].count, 11u);
+
+    std::mt19937 rng(7);
+    for (int i = 0; i < 5000; ++i) {
+        const std::size_t length = rng() % 3 == 0 ? 60 + rng() % 60 : 1;
+        offer(std::string(length, static_cast<char>('a' + rng() % 4)));
+    }
+
+    for (const auto& entry : sketch.getTop(100)) {
+        const std::uint64_t actual = truth[std::string(entry.key)];
+        EXPECT_GE(entry.count, actual) << entry.key;
+        EXPECT_LE(entry.count - entry.error, actual) << entry.key;
+    }
+    for (const auto& [key, count] : truth) {
+        if (count > sketch.getMaxError()) {
+            EXPECT_TRUE(sketch.contains(key)) << key;
+        }
+    }
+}
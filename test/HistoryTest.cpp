@@ -0,0 +1,343 @@
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/filter/zstd.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "History.hpp"
+
+using namespace stars;
+
+TEST(HistoryTest, MapsRegularFile) {
+    History history;
+    history.loadFromFile("resources/.bash_history");
+
+    const auto& lines = history.getLines();
+    ASSERT_EQ(lines.size(), 26u);
+    EXPECT_EQ(lines.front(), "ls");
+    EXPECT_EQ(lines[2], "ls -l");
+    EXPECT_EQ(lines.back(), "pwd -L");
+}
+
+TEST(HistoryTest, BuffersPipeInput) {
+    int fds[2];
+    ASSERT_EQ(::pipe(fds), 0);
+    const std::string payload = "ls -a\n\n# comment\ngit log\n";
+    ASSERT_EQ(::write(fds[1], payload.data(), payload.size()), static_cast<ssize_t>(payload.size()));
+    ::close(fds[1]);
+
+    History history;
+    history.loadFromFile("/proc/self/fd/" + std::to_string(fds[0]));
+    ::close(fds[0]);
+
+    const auto& lines = history.getLines();
+    ASSERT_EQ(lines.size(), 4u);
+    EXPECT_EQ(lines[0], "ls -a");
+    EXPECT_EQ(lines[1], "");
+    EXPECT_EQ(lines[2], "# comment");
+    EXPECT_EQ(lines[3], "git log");
+}
+
+TEST(HistoryTest, RefusesToRewindPipes) {
+    int fds[2];
+    ASSERT_EQ(::pipe(fds), 0);
+    const std::string payload = "ls\ngit log\n";
+    ASSERT_EQ(::write(fds[1], payload.data(), payload.size()), static_cast<ssize_t>(payload.size()));
+    ::close(fds[1]);
+    const std::string path = "/proc/self/fd/" + std::to_string(fds[0]);
+    EXPECT_TRUE(History::isReadOnce(path));
+    EXPECT_TRUE(History::isReadOnce("-"));
+    EXPECT_FALSE(History::isReadOnce("resources/.bash_history"));
+    EXPECT_FALSE(History::isReadOnce("resources/does-not-exist"));
+
+    // Reopened by name, the drained pipe would read as empty rather than replay its lines.
+    History history;
+    history.setStreaming(true);
+    history.loadFromFile(path);
+    while (history.readBatch(1 << 20)) {
+    }
+    EXPECT_THROW(history.restartBatches(), std::runtime_error);
+    ::close(fds[0]);
+}
+
+TEST(HistoryTest, ThrowsOnMissingFile) {
+    History history;
+    EXPECT_THROW(history.loadFromFile("resources/does-not-exist"), std::runtime_error);
+}
+
+TEST(HistoryTest, ScannerMatchesGetlineAcrossBlockBoundaries) {
+    // Lines of varied length so newlines and '#' land on every SSE2/AVX2 lane and block edge.
+    std::string payload;
+    std::vector<std::string> expected;
+    for (int i = 0; i < 400; ++i) {
+        std::string line;
+        if (i % 7 == 0) line = "";
+        else if (i % 5 == 0) line = "#" + std::to_string(1700000000 + i);
+        else line = "cmd" + std::string(static_cast<std::size_t>(i % 37), 'x') + " -f";
+        expected.push_back(line);
+        payload += line + "\n";
+    }
+    payload += "tail without newline";
+    expected.push_back("tail without newline");
+
+    int fds[2];
+    ASSERT_EQ(::pipe(fds), 0);
+    // Close the write end whatever happens, or a failed write would leave the load blocked.
+    ssize_t written = -1;
+    std::thread writer([&] {
+        written = ::write(fds[1], payload.data(), payload.size());
+        ::close(fds[1]);
+    });
+    History history;
+    history.loadFromFile("/proc/self/fd/" + std::to_string(fds[0]));
+    writer.join();
+    ::close(fds[0]);
+    ASSERT_EQ(written, static_cast<ssize_t>(payload.size()));
+
+    const auto& lines = history.getLines();
+    const auto& skippable = history.getSkippable();
+    ASSERT_EQ(lines.size(), expected.size());
+    ASSERT_EQ(skippable.size(), expected.size());
+    for (std::size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_EQ(lines[i], expected[i]) << "line " << i;
+        EXPECT_EQ(skippable[i], expected[i].empty() || expected[i][0] == '#') << "line " << i;
+    }
+}
+
+namespace {
+
+std::filesystem::path scratchFile(const std::string& name) {
+    auto dir = std::filesystem::temp_directory_path() / ("stars-test-" + std::to_string(::getpid()));
+    std::filesystem::create_directories(dir);
+    return dir / name;
+}
+
+void appendText(const std::filesystem::path& path, const std::string& text) {
+    std::ofstream out(path, std::ios::app | std::ios::binary);
+    out << text;
+}
+
+}  // namespace
+
+TEST(HistoryTest, ScanKernelsAgreeWithScalar) {
+    // Runs of '#' and newlines of every length up to two AVX2 blocks, at every offset.
+    std::string payload;
+    for (std::size_t i = 0; i < 600; ++i) {
+        payload += std::string(i % 67, i % 3 == 0 ? '#' : 'x');
+        payload += std::string(1 + i % 4, '\n');
+        if (i % 11 == 0) payload += "#\n";
+    }
+    payload += "#tail";
+    auto path = scratchFile("kernels");
+    std::filesystem::remove(path);
+    appendText(path, payload);
+
+    auto scan = [&](History::ScanKernel kernel, std::vector<std::string>& lines, std::vector<bool>& skippable) {
+        if (!History::setScanKernel(kernel)) return false;
+        History history;
+        history.loadFromFile(path.string());
+        lines.assign(history.getLines().begin(), history.getLines().end());
+        skippable = history.getSkippable();
+        return true;
+    };
+
+    std::vector<std::string> scalarLines;
+    std::vector<bool> scalarSkippable;
+    ASSERT_TRUE(scan(History::ScanKernel::Scalar, scalarLines, scalarSkippable));
+    for (auto kernel : {History::ScanKernel::Sse2, History::ScanKernel::Avx2, History::ScanKernel::Auto}) {
+        std::vector<std::string> lines;
+        std::vector<bool> skippable;
+        if (!scan(kernel, lines, skippable)) continue;  // Not supported by this CPU.
+        EXPECT_EQ(lines, scalarLines) << "kernel " << static_cast<int>(kernel);
+        EXPECT_EQ(skippable, scalarSkippable) << "kernel " << static_cast<int>(kernel);
+    }
+    History::setScanKernel(History::ScanKernel::Auto);
+}
+
+TEST(HistoryTest, ReadAppendedReturnsOnlyNewCompleteLines) {
+    const auto path = scratchFile("append_history");
+    std::filesystem::remove(path);
+    appendText(path, "ls\ncd ..\n");
+
+    History history;
+    history.loadFromFile(path.string());
+    ASSERT_EQ(history.getLines().size(), 2u);
+
+    EXPECT_EQ(history.readAppended(), 0u);
+
+    appendText(path, "git log\n# 1700000000\nmake -j");
+    ASSERT_EQ(history.readAppended(), 2u);
+    EXPECT_EQ(history.getFirstLineNumber(), 2u);
+    EXPECT_EQ(history.getLines()[0], "git log");
+    EXPECT_TRUE(history.getSkippable()[1]);
+
+    // The partial "make -j" line is completed and numbered after the previous batch.
+    appendText(path, "8\n");
+    ASSERT_EQ(history.readAppended(), 1u);
+    EXPECT_EQ(history.getFirstLineNumber(), 4u);
+    EXPECT_EQ(history.getLines()[0], "make -j8");
+}
+
+TEST(HistoryTest, ReadAppendedHandlesTruncationAndRotation) {
+    const auto path = scratchFile("rotate_history");
+    std::filesystem::remove(path);
+    appendText(path, "ls\ncd ..\npwd\n");
+
+    History history;
+    history.loadFromFile(path.string());
+
+    // Truncated and rewritten shorter: the current end becomes the baseline.
+    std::filesystem::resize_file(path, 3);
+    EXPECT_EQ(history.readAppended(), 0u);
+    appendText(path, "top\n");
+    ASSERT_EQ(history.readAppended(), 1u);
+    EXPECT_EQ(history.getLines()[0], "top");
+
+    // Rotated: a new file under the same name is read from its start.
+    const auto rotated = scratchFile("rotate_history.1");
+    std::filesystem::rename(path, rotated);
+    appendText(path, "echo new\n");
+    ASSERT_EQ(history.readAppended(), 1u);
+    EXPECT_EQ(history.getLines()[0], "echo new");
+    std::filesystem::remove(rotated);
+}
+
+TEST(HistoryTest, FollowWakesUpOnAppend) {
+    const auto path = scratchFile("follow_history");
+    std::filesystem::remove(path);
+    appendText(path, "ls\n");
+
+    History history;
+    history.loadFromFile(path.string());
+    history.follow();
+
+    std::thread writer([&] { appendText(path, "git status\n"); });
+    history.waitForChange();
+    writer.join();
+
+    ASSERT_EQ(history.readAppended(), 1u);
+    EXPECT_EQ(history.getLines()[0], "git status");
+}
+
+TEST(HistoryTest, FollowDrainsTheOldFileOnRotation) {
+    const auto path = scratchFile("follow_rotate_history");
+    const auto rotated = scratchFile("follow_rotate_history.1");
+    std::filesystem::remove(path);
+    std::filesystem::remove(rotated);
+    appendText(path, "ls\n");
+
+    History history;
+    history.loadFromFile(path.string());
+    history.follow();
+
+    // Written before the rotation was noticed, and after it, to the old name and the new one.
+    appendText(path, "make\n");
+    std::filesystem::rename(path, rotated);
+    appendText(rotated, "git log");
+    appendText(path, "echo new\n");
+    ASSERT_TRUE(history.waitForChange(std::chrono::seconds(5)));
+
+    ASSERT_EQ(history.readAppended(), 3u);
+    EXPECT_EQ(history.getFirstLineNumber(), 1u);
+    EXPECT_EQ(history.getLines()[0], "make");
+    EXPECT_EQ(history.getLines()[1], "git log");
+    EXPECT_EQ(history.getLines()[2], "echo new");
+    // The fingerprint covers the file now at the path, not the drained lines.
+    EXPECT_EQ(history.getFingerprint().size, 9u);
+    EXPECT_EQ(history.getFingerprint().tailHash, History::hashBytes("echo new\n"));
+
+    // Only the new file is read from here on.
+    appendText(rotated, "lost\n");
+    appendText(path, "pwd\n");
+    ASSERT_TRUE(history.waitForChange(std::chrono::seconds(5)));
+    ASSERT_EQ(history.readAppended(), 1u);
+    EXPECT_EQ(history.getLines()[0], "pwd");
+    std::filesystem::remove(rotated);
+}
+
+TEST(HistoryTest, ResumesAfterUnchangedPrefix) {
+    const auto path = scratchFile("resume_history");
+    std::filesystem::remove(path);
+    appendText(path, "ls\ncd ..\n");
+
+    History first;
+    first.loadFromFile(path.string());
+    const auto fingerprint = first.getFingerprint();
+    EXPECT_EQ(fingerprint.lineCount, 2u);
+    EXPECT_TRUE(fingerprint.endsWithNewline);
+
+    // Grown: only the new lines are scanned, numbered after the prefix.
+    appendText(path, "git status\n");
+    History grown;
+    ASSERT_TRUE(grown.loadFromFile(path.string(), fingerprint));
+    ASSERT_EQ(grown.getLines().size(), 1u);
+    EXPECT_EQ(grown.getLines()[0], "git status");
+    EXPECT_EQ(grown.getFirstLineNumber(), 2u);
+
+    // Rewritten prefix: the tail hash no longer matches, so everything is reloaded.
+    std::filesystem::remove(path);
+    appendText(path, "pwd\ncd ..\ngit status\n");
+    History rewritten;
+    EXPECT_FALSE(rewritten.loadFromFile(path.string(), fingerprint));
+    EXPECT_EQ(rewritten.getLines().size(), 3u);
+    EXPECT_EQ(rewritten.getFirstLineNumber(), 0u);
+}
+
+TEST(HistoryTest, DecodesGzipAndZstdInStreamedBatches) {
+    std::string payload;
+    for (int i = 0; i < 20000; ++i) {
+        payload += "#" + std::to_string(1700000000 + i) + "\ngit commit -m 'change " + std::to_string(i) + "'\n";
+    }
+    payload += "ls -l";  // No trailing newline.
+
+    History plain;
+    const auto plainPath = std::filesystem::temp_directory_path() / ("stars-plain-" + std::to_string(::getpid()));
+    std::ofstream(plainPath) << payload;
+    plain.loadFromFile(plainPath.string());
+    EXPECT_EQ(plain.getCompression(), History::Compression::None);
+
+    for (const auto compression : {History::Compression::Gzip, History::Compression::Zstd}) {
+        const auto path = std::filesystem::temp_directory_path() / ("stars-packed-" + std::to_string(::getpid()));
+        {
+            std::ofstream file(path, std::ios::binary);
+            boost::iostreams::filtering_ostream out;
+            if (compression == History::Compression::Gzip) out.push(boost::iostreams::gzip_compressor());
+            if (compression == History::Compression::Zstd) out.push(boost::iostreams::zstd_compressor());
+            out.push(file);
+            out << payload;
+        }
+
+        History whole;
+        whole.loadFromFile(path.string());
+        EXPECT_EQ(whole.getCompression(), compression);
+        EXPECT_EQ(whole.getLines(), plain.getLines());
+        // Decoded bytes are not the file's: nothing to validate a snapshot against.
+        EXPECT_TRUE(whole.getFingerprint().path.empty());
+
+        // Small batches split lines across decoded chunks; earlier batches stay readable while held.
+        History streamed;
+        streamed.setStreaming(true);
+        streamed.loadFromFile(path.string());
+        for (int pass = 0; pass < 2; ++pass) {
+            std::vector<std::shared_ptr<const char>> held;
+            std::vector<std::string_view> lines;
+            while (streamed.readBatch(1000)) {
+                EXPECT_EQ(streamed.getFirstLineNumber(), lines.size());
+                held.push_back(streamed.getData());
+                lines.insert(lines.end(), streamed.getLines().begin(), streamed.getLines().end());
+            }
+            EXPECT_EQ(lines, plain.getLines());
+            streamed.restartBatches();
+        }
+        std::filesystem::remove(path);
+    }
+    std::filesystem::remove(plainPath);
+}
@@ -0,0 +1,141 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Command.hpp"
+#include "Graph.hpp"
+#include "Layout.hpp"
+
+using namespace stars;
+
+TEST(LayoutTest, PlacesOnlyShownConstellationsAndReusesBuffers) {
+    Command::Arena arena;
+    Graph graph;
+    graph.build(Command::parseLines({"ls -l", "ls -a", "ls -l -a", "git log", "make"}, arena));
+    const Graph::Frozen frozen = graph.freeze();
+
+    Layout layout;
+    layout.compute(frozen, 120, 40, 1);
+    const auto ls = frozen.getBaseVertices()[0];
+    ASSERT_EQ(frozen.getLabel(ls), "<ls>");
+    EXPECT_TRUE(layout.isPlaced(ls));
+    for (auto v : frozen.getVariantsForBase(ls)) EXPECT_TRUE(layout.isPlaced(v));
+    for (auto base : frozen.getBaseVertices().subspan(1)) {
+        EXPECT_FALSE(layout.isPlaced(base));
+        for (auto v : frozen.getVariantsForBase(base)) EXPECT_FALSE(layout.isPlaced(v));
+    }
+    EXPECT_FALSE(layout.isPlaced(frozen.getVertexCount() + 100));
+
+    // A re-layout of the same graph lands in the same storage.
+    const auto* storage = layout.getPositions().data();
+    layout.compute(frozen, 120, 40, 3);
+    EXPECT_EQ(layout.getPositions().data(), storage);
+    for (auto base : frozen.getBaseVertices()) EXPECT_TRUE(layout.isPlaced(base));
+}
+
+TEST(LayoutTest, PackedStarsAndLabelsNeverOverlap) {
+    std::vector<std::string> storage;
+    for (int base = 0; base < 40; ++base) {
+        for (int variant = 0; variant <= base % 7; ++variant) {
+            std::string line = "cmd" + std::to_string(base);
+            for (int flag = 0; flag <= variant % 3; ++flag) {
+                line += " -" + std::string(1, static_cast<char>('a' + variant + flag));
+            }
+            for (int use = 0; use < 40 - base; ++use) storage.push_back(line);
+        }
+    }
+    const std::vector<std::string_view> lines(storage.begin(), storage.end());
+    Command::Arena arena;
+    Graph graph;
+    graph.build(Command::parseLines(lines, arena));
+    const Graph::Frozen frozen = graph.freeze();
+
+    constexpr std::size_t kWidth = 160;
+    constexpr std::size_t kHeight = 48;
+    Layout layout;
+    layout.compute(frozen, kWidth, kHeight, 40);
+
+    std::vector<std::string> canvas(kHeight, std::string(kWidth, ' '));
+    std::size_t placed = 0;
+    for (Graph::Vertex v = 0; v < frozen.getVertexCount(); ++v) {
+        if (!layout.isPlaced(v)) continue;
+        ++placed;
+        const auto p = layout.getPosition(v);
+        ASSERT_LT(p.x, kWidth);
+        ASSERT_LT(p.y, kHeight);
+        const std::size_t end = std::min(kWidth, p.x + 1 + frozen.getLabel(v).size());
+        for (std::size_t x = p.x; x < end; ++x) {
+            EXPECT_EQ(canvas[p.y][x], ' ') << frozen.getLabel(v);
+            canvas[p.y][x] = '#';
+        }
+    }
+
+    // Several columns of constellations, most used at the top left.
+    EXPECT_GT(placed, 60u);
+    const auto bases = frozen.getBaseVertices();
+    const auto top = *std::max_element(bases.begin(), bases.end(), [&frozen](auto a, auto b) {
+        return frozen.getFrequency(a) < frozen.getFrequency(b);
+    });
+    ASSERT_TRUE(layout.isPlaced(top));
+    EXPECT_EQ(layout.getPosition(top).x, 0u);
+    std::size_t rightmost = 0;
+    for (auto base : bases) {
+        if (layout.isPlaced(base)) rightmost = std::max(rightmost, layout.getPosition(base).x);
+    }
+    EXPECT_GT(rightmost, kWidth / 3);
+}
+
+TEST(LayoutTest, ForceModeMatchesAcrossThreadCountsWithoutOverlaps) {
+    std::vector<std::string> storage;
+    for (int base = 0; base < 60; ++base) {
+        for (int variant = 0; variant < 64; ++variant) {
+            std::string line = "c" + std::to_string(base);
+            for (int flag = 0; flag < 6; ++flag) {
+                if ((variant >> flag) & 1) line += " -" + std::string(1, static_cast<char>('a' + flag));
+            }
+            storage.push_back(line);
+        }
+    }
+    const std::vector<std::string_view> lines(storage.begin(), storage.end());
+    Command::Arena arena;
+    Graph graph;
+    graph.build(Command::parseLines(lines, arena));
+    const Graph::Frozen frozen = graph.freeze();
+    ASSERT_GT(frozen.getVertexCount(), 3000u);
+
+    constexpr std::size_t kWidth = 300;
+    constexpr std::size_t kHeight = 100;
+    auto run = [&](std::size_t threads) {
+        Layout layout;
+        layout.setMode(Layout::Mode::Force);
+        layout.setForceBudget(20, std::chrono::minutes(1));
+        layout.setThreads(threads);
+        layout.compute(frozen, kWidth, kHeight, 60);
+        return layout;
+    };
+    const Layout serial = run(1);
+    const Layout parallel = run(3);
+
+    std::vector<std::string> canvas(kHeight, std::string(kWidth, ' '));
+    std::size_t placed = 0;
+    for (Graph::Vertex v = 0; v < frozen.getVertexCount(); ++v) {
+        ASSERT_EQ(parallel.isPlaced(v), serial.isPlaced(v));
+        if (!serial.isPlaced(v)) continue;
+        ++placed;
+        const auto p = serial.getPosition(v);
+        EXPECT_EQ(parallel.getPosition(v).x, p.x);
+        EXPECT_EQ(parallel.getPosition(v).y, p.y);
+        ASSERT_LT(p.y, kHeight);
+        const std::size_t end = std::min(kWidth, p.x + 1 + frozen.getLabel(v).size());
+        for (std::size_t x = p.x; x < end; ++x) {
+            EXPECT_EQ(canvas[p.y][x], ' ');
+            canvas[p.y][x] = '#';
+        }
+    }
+    EXPECT_GT(placed, 500u);
+    for (auto base : frozen.getBaseVertices()) EXPECT_TRUE(serial.isPlaced(base));
+}
@@ -0,0 +1,213 @@
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Pipeline.hpp"
+
+using namespace stars;
+
+TEST(PipelineTest, QueueDeliversEveryItemOnceUnderContention) {
+    Pipeline::BoundedQueue<int> queue(8);
+    constexpr int kProducers = 3;
+    constexpr int kPerProducer = 20000;
+
+    std::vector<int> seen(kProducers * kPerProducer, 0);
+    {
+        std::vector<std::jthread> threads;
+        for (int p = 0; p < kProducers; ++p) {
+            threads.emplace_back([&, p] {
+                for (int i = 0; i < kPerProducer; ++i) queue.push(p * kPerProducer + i);
+            });
+        }
+        for (int c = 0; c < 2; ++c) {
+            threads.emplace_back([&] {
+                // -1 stops one consumer; each consumer's slots are disjoint, so no extra locking.
+                for (int value = queue.pop(); value >= 0; value = queue.pop()) ++seen[static_cast<std::size_t>(value)];
+            });
+        }
+        for (int p = 0; p < kProducers; ++p) threads[static_cast<std::size_t>(p)].join();
+        queue.push(-1);
+        queue.push(-1);
+    }
+
+    EXPECT_EQ(std::count(seen.begin(), seen.end(), 1), kProducers * kPerProducer);
+
+    int value = 0;
+    EXPECT_FALSE(queue.tryPop(value));
+}
+
+TEST(PipelineTest, StreamedGraphMatchesBatchBuild) {
+    const auto path = std::filesystem::temp_directory_path() / ("stars-pipeline-" + std::to_string(::getpid()));
+    {
+        std::mt19937 rng(3);
+        std::ofstream out(path);
+        for (int i = 0; i < 30000; ++i) {
+            if (rng() % 10 == 0) out << "#" << i << "\n";
+            out << "cmd" << rng() % 25;
+            for (unsigned f = rng() % 4; f > 0; --f) out << " -" << rng() % 9;
+            if (rng() % 7 == 0) out << " 'quoted arg'";
+            out << "\n";
+        }
+        out << "tail -n 5";  // No trailing newline.
+    }
+
+    History whole;
+    whole.loadFromFile(path.string());
+    Command::Arena arena;
+    Graph expected;
+    expected.build(Command::parseLines(whole.getLines(), arena, whole.getSkippable()));
+
+    // One parser folds in place; three shard the graph by base and stitch it at the end.
+    for (std::size_t parsers : {1, 3}) {
+        History streamed;
+        streamed.setStreaming(true);
+        streamed.loadFromFile(path.string());
+        EXPECT_TRUE(streamed.getLines().empty());
+        Graph graph;
+        const std::size_t commands = Pipeline(parsers, 4096, 4).run(streamed, graph);
+
+        const auto& a = expected.getBoostGraph();
+        const auto& b = graph.getBoostGraph();
+        ASSERT_EQ(boost::num_vertices(b), boost::num_vertices(a));
+        ASSERT_EQ(boost::num_edges(b), boost::num_edges(a));
+        for (auto v : boost::make_iterator_range(boost::vertices(a))) {
+            EXPECT_EQ(graph.getLabel(v), expected.getLabel(v));
+            EXPECT_EQ(b[v].frequency, a[v].frequency);
+            EXPECT_EQ(b[v].firstSeenIndex, a[v].firstSeenIndex);
+            std::vector<Graph::Vertex> targetsA, targetsB;
+            for (auto e : boost::make_iterator_range(boost::out_edges(v, a))) targetsA.push_back(boost::target(e, a));
+            for (auto e : boost::make_iterator_range(boost::out_edges(v, b))) targetsB.push_back(boost::target(e, b));
+            EXPECT_EQ(targetsB, targetsA);
+        }
+
+        // Every command lands on exactly one variant star.
+        std::size_t total = 0;
+        for (auto v : boost::make_iterator_range(boost::vertices(a))) {
+            if (!a[v].isBase) total += a[v].frequency;
+        }
+        EXPECT_EQ(commands, total);
+
+        // Fully consumed: the fingerprint covers every line, as after a whole load.
+        EXPECT_EQ(streamed.getFingerprint().lineCount, whole.getFingerprint().lineCount);
+    }
+    std::filesystem::remove(path);
+}
+
+TEST(PipelineTest, StreamedAppendsOntoLoadedGraphMatchOneAppend) {
+    const auto path = std::filesystem::temp_directory_path() / ("stars-append-" + std::to_string(::getpid()));
+    {
+        std::ofstream out(path);
+        for (int i = 0; i < 5000; ++i) out << "cmd" << i % 7 << " -" << i % 5 << (i % 3 ? " -x" : "") << "\n";
+    }
+
+    Command::Arena arena;
+    const std::vector<std::string_view> seed{"cmd1 -9", "cmd3 -x"};
+    History whole;
+    whole.loadFromFile(path.string());
+    Graph expected;
+    expected.build(Command::parseLines(seed, arena));
+    expected.append(Command::parseLines(whole.getLines(), arena, whole.getSkippable()));
+
+    // A graph that already holds stars is folded in place, chains linked once at the end.
+    Graph graph;
+    graph.build(Command::parseLines(seed, arena));
+    History streamed;
+    streamed.setStreaming(true);
+    streamed.loadFromFile(path.string());
+    Pipeline(3, 1024, 4).run(streamed, graph);
+
+    const auto a = expected.freeze();
+    const auto b = graph.freeze();
+    ASSERT_EQ(b.getVertexCount(), a.getVertexCount());
+    for (Graph::Vertex v = 0; v < a.getVertexCount(); ++v) {
+        EXPECT_EQ(b.getLabel(v), a.getLabel(v));
+        EXPECT_EQ(b.getFrequency(v), a.getFrequency(v));
+        EXPECT_TRUE(std::ranges::equal(b.getOutEdges(v), a.getOutEdges(v)));
+    }
+    std::filesystem::remove(path);
+}
+
+TEST(PipelineTest, TopKKeepsOnlyMostUsedConstellationsWithExactCounts) {
+    const auto path = std::filesystem::temp_directory_path() / ("stars-topk-" + std::to_string(::getpid()));
+    {
+        std::ofstream out(path);
+        // A repeated flag is the same variant as "ls -l"; its own spelling is too rare to be monitored.
+        out << "ls -l -l\n";
+        for (int i = 0; i < 2000; ++i) {
+            out << "git status\n";
+            if (i % 2 == 0) out << "ls -l\n";
+            if (i % 4 == 0) out << "ls -a -l\n";
+            out << "once" << i << " -x\n";  // A long tail that must not reach the graph.
+        }
+    }
+
+    History history;
+    history.setStreaming(true);
+    history.loadFromFile(path.string());
+    Graph graph;
+    const std::size_t kept = Pipeline(2, 1024, 3).runTopK(history, graph, 2, 64 * 1024);
+    EXPECT_EQ(kept, 2000u + 1000u + 500u + 1u);
+
+    const Graph::Frozen frozen = graph.freeze();
+    const auto bases = frozen.getBaseVertices();
+    ASSERT_EQ(bases.size(), 2u);
+    EXPECT_EQ(frozen.getLabel(bases[0]), "<ls>");
+    EXPECT_EQ(frozen.getFrequency(bases[0]), 1501u);
+    EXPECT_EQ(frozen.getLabel(bases[1]), "<git>");
+    EXPECT_EQ(frozen.getFrequency(bases[1]), 2000u);
+    std::filesystem::remove(path);
+}
+
+TEST(PipelineTest, MergedHistoriesInterleaveByTimestamp) {
+    const auto directory = std::filesystem::temp_directory_path() / ("stars-merge-" + std::to_string(::getpid()));
+    std::filesystem::create_directories(directory);
+
+    // Each host runs its own command at its own pace; zsh and bash files mixed.
+    std::vector<std::string> paths;
+    std::size_t expected = 0;
+    for (int host = 0; host < 5; ++host) {
+        const auto path = directory / ("host" + std::to_string(host));
+        std::ofstream out(path);
+        for (int i = 0; i < 3000; ++i) {
+            const std::int64_t time = 1700000000 + i * (host + 1);
+            if (host % 2 == 0) {
+                out << ": " << time << ":0;cmd" << host << " -" << i % 3 << "\n";
+            } else {
+                out << "#" << time << "\ncmd" << host << " -" << i % 3 << "\n";
+            }
+            ++expected;
+        }
+        paths.push_back(path.string());
+    }
+
+    std::vector<std::int64_t> times;
+    std::vector<std::size_t> indices;
+    const std::size_t commands = Pipeline(3, 4096).runMerged(paths, [&](std::vector<Command>& batch) {
+        for (const Command& cmd : batch) {
+            ASSERT_EQ(cmd.base.substr(0, 3), "cmd");
+            times.push_back(cmd.timestamp);
+            indices.push_back(cmd.index);
+        }
+    });
+
+    EXPECT_EQ(commands, expected);
+    ASSERT_EQ(times.size(), expected);
+    EXPECT_TRUE(std::is_sorted(times.begin(), times.end()));
+    for (std::size_t i = 0; i < indices.size(); ++i) EXPECT_EQ(indices[i], i);
+
+    // The merged galaxy holds every host's constellation with exact counts.
+    Graph graph;
+    Pipeline(2).runMerged(paths, graph);
+    const auto frozen = graph.freeze();
+    ASSERT_EQ(frozen.getBaseVertices().size(), 5u);
+    for (auto base : frozen.getBaseVertices()) EXPECT_EQ(frozen.getFrequency(base), 3000u);
+    std::filesystem::remove_all(directory);
+}
@@ -0,0 +1,170 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Command.hpp"
+#include "Graph.hpp"
+#include "Layout.hpp"
+#include "Renderer.hpp"
+
+using namespace stars;
+
+namespace {
+
+std::atomic<std::size_t> allocations{0};
+
+}  // namespace
+
+// Count every heap allocation in the test binary; render() at a steady size should make none.
+void* operator new(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size == 0 ? 1 : size)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+TEST(RendererTest, RedrawAtSameSizeReusesFramebuffer) {
+    Command::Arena arena;
+    Graph graph;
+    graph.build(Command::parseLines({"ls -l", "ls -a", "ls -l -a", "git log", "git log --oneline", "make"}, arena));
+    const Graph::Frozen frozen = graph.freeze();
+
+    constexpr std::size_t kWidth = 100;
+    constexpr std::size_t kHeight = 30;
+    Layout layout;
+    layout.compute(frozen, kWidth, kHeight, 3);
+    Renderer renderer;
+
+    const std::string first(renderer.render(frozen, layout));
+    ASSERT_EQ(first.size(), kHeight * (kWidth + 1));
+    EXPECT_EQ(std::count(first.begin(), first.end(), '\n'), static_cast<long>(kHeight));
+    EXPECT_NE(first.find("<ls>"), std::string::npos);
+
+    // A second frame overwrites the first in place instead of stacking rows after it.
+    const std::size_t before = allocations.load();
+    const std::string_view second = renderer.render(frozen, layout);
+    const std::size_t after = allocations.load();
+    EXPECT_EQ(after, before);
+    EXPECT_EQ(second, first);
+
+    // A smaller canvas shrinks the output to match.
+    layout.compute(frozen, kWidth / 2, kHeight / 2, 1);
+    EXPECT_EQ(renderer.render(frozen, layout).size(), (kHeight / 2) * (kWidth / 2 + 1));
+}
+
+TEST(RendererTest, TiledEdgesMatchSerialDrawing) {
+    std::vector<std::string> storage;
+    for (int base = 0; base < 60; ++base) {
+        for (int variant = 0; variant < 120; ++variant) {
+            std::string line = "c" + std::to_string(base);
+            for (int bit = 0; bit < 7; ++bit) {
+                if (variant >> bit & 1) line += " -" + std::string(1, static_cast<char>('a' + bit));
+            }
+            storage.push_back(line);
+        }
+    }
+    const std::vector<std::string_view> lines(storage.begin(), storage.end());
+    Command::Arena arena;
+    Graph graph;
+    graph.build(Command::parseLines(lines, arena));
+    const Graph::Frozen frozen = graph.freeze();
+
+    Layout layout;
+    layout.compute(frozen, 3000, 600, 60);
+    std::size_t edges = 0;
+    for (Graph::Vertex v = 0; v < frozen.getVertexCount(); ++v) {
+        if (!layout.isPlaced(v)) continue;
+        for (auto dst : frozen.getOutEdges(v)) edges += layout.isPlaced(dst);
+    }
+    ASSERT_GE(edges, 3u * 2048u);  // Enough to split across three workers.
+
+    Renderer serial;
+    serial.setThreads(1);
+    const std::string expected(serial.render(frozen, layout));
+    for (std::size_t threads : {2, 3}) {
+        Renderer tiled;
+        tiled.setThreads(threads);
+        EXPECT_EQ(tiled.render(frozen, layout), expected);
+    }
+}
+
+TEST(RendererTest, HeatmapColoursOnlyWherePenChanges) {
+    std::vector<std::string> storage;
+    for (int use = 0; use < 200; ++use) storage.push_back("ls -l");
+    for (int use = 0; use < 20; ++use) storage.push_back("ls -a");
+    storage.push_back("ls -a -l");
+    storage.push_back("cd -P");
+    const std::vector<std::string_view> lines(storage.begin(), storage.end());
+    Command::Arena arena;
+    Graph graph;
+    graph.build(Command::parseLines(lines, arena));
+    const Graph::Frozen frozen = graph.freeze();
+
+    Layout layout;
+    layout.compute(frozen, 100, 30, 2);
+    Renderer plain;
+    const std::string expected(plain.render(frozen, layout));
+
+    for (auto palette : {Renderer::Palette::Ansi256, Renderer::Palette::TrueColor}) {
+        Renderer renderer;
+        renderer.setPalette(palette);
+        const std::string coloured(renderer.render(frozen, layout));
+
+        // Dropping the escapes leaves the plain picture; one escape per colour change in a row.
+        std::string text;
+        std::size_t escapes = 0;
+        for (std::size_t i = 0; i < coloured.size(); ++i) {
+            if (coloured[i] != '\x1b') {
+                text += coloured[i];
+                continue;
+            }
+            ++escapes;
+            i = coloured.find('m', i);
+        }
+        EXPECT_EQ(text, expected);
+
+        std::size_t changes = 0;
+        const auto [width, height] = renderer.getCanvasSize();
+        for (std::size_t y = 0; y < height; ++y) {
+            std::uint8_t pen = 0;
+            for (std::size_t x = 0; x < width; ++x) {
+                const auto& cell = renderer.getFrame()[y * width + x];
+                if (cell.glyph != ' ' && cell.heat != pen) {
+                    ++changes;
+                    pen = cell.heat;
+                }
+            }
+            changes += pen != 0;  // Reset at the end of the row.
+        }
+        EXPECT_EQ(escapes, changes);
+
+        // The most used base glows hottest, and heat follows use.
+        auto heatOf = [&](std::string_view label) {
+            for (Graph::Vertex v = 0; v < frozen.getVertexCount(); ++v) {
+                if (frozen.getLabel(v) != label) continue;
+                const auto p = layout.getPosition(v);
+                return static_cast<int>(renderer.getFrame()[p.y * width + p.x].heat);
+            }
+            return -1;
+        };
+        EXPECT_EQ(heatOf("<ls>"), 255);
+        EXPECT_GT(heatOf("<ls>"), heatOf("<ls -l>"));
+        EXPECT_GT(heatOf("<ls -l>"), heatOf("<ls -a>"));
+        EXPECT_GT(heatOf("<ls -a>"), heatOf("<cd -P>"));
+        EXPECT_GT(heatOf("<cd -P>"), 0);
+    }
+}